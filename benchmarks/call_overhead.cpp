@@ -0,0 +1,155 @@
+// Measures the time per call of small wrappers whose cost is mostly the
+// trip into python, next to the ways they used to make that trip: the
+// pyplot function resolved once but called with a freshly packed argument
+// tuple, and looked up again by name on every call. The first row calls a
+// python function that does nothing, so it shows the dispatch cost alone.
+#include "../matplotlibcpp.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+static PyObject* pyplot()
+{
+    return plt::detail::_interpreter::get().s_python_module_pyplot;
+}
+
+// Exits with python's error if res is NULL, and drops res otherwise.
+static void check(PyObject* res)
+{
+    if (!res) {
+        PyErr_Print();
+        exit(1);
+    }
+    Py_DECREF(res);
+}
+
+// fn(*args), with args packed into a new tuple. Steals args.
+static void tuple_call(PyObject* fn, std::initializer_list<PyObject*> args)
+{
+    PyObject* tuple = PyTuple_New(args.size());
+    Py_ssize_t i = 0;
+    for (PyObject* arg : args)
+        PyTuple_SetItem(tuple, i++, arg);
+    check(PyObject_Call(fn, tuple, NULL));
+    Py_DECREF(tuple);
+}
+
+// The same, with fn looked up as an attribute of o first.
+static void lookup_call(PyObject* o, const char* name, std::initializer_list<PyObject*> args)
+{
+    PyObject* fn = PyObject_GetAttrString(o, name);
+    if (!fn) {
+        PyErr_Print();
+        exit(1);
+    }
+    tuple_call(fn, args);
+    Py_DECREF(fn);
+}
+
+static PyObject* pair(double a, double b)
+{
+    PyObject* list = PyList_New(2);
+    PyList_SetItem(list, 0, PyFloat_FromDouble(a));
+    PyList_SetItem(list, 1, PyFloat_FromDouble(b));
+    return list;
+}
+
+template<typename Call>
+double ns_per_call(int calls, const Call& call)
+{
+    call();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int c = 0; c < calls; ++c)
+        call();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / calls;
+}
+
+template<typename Wrapper, typename Tuple, typename Lookup>
+void bench(const char* name, int calls, const Wrapper& wrapper, const Tuple& tuple, const Lookup& lookup)
+{
+    printf("%-18s %10.0f %10.0f %10.0f\n", name,
+           ns_per_call(calls, wrapper), ns_per_call(calls, tuple), ns_per_call(calls, lookup));
+}
+
+int main()
+{
+    const int calls = 10000;
+    plt::plot(std::vector<double>{1.0, 2.0, 3.0});
+
+    PyObject* xlim = PyObject_GetAttrString(pyplot(), "xlim");
+    PyObject* axis = PyObject_GetAttrString(pyplot(), "axis");
+    PyObject* grid = PyObject_GetAttrString(pyplot(), "grid");
+    PyObject* fignum_exists = PyObject_GetAttrString(pyplot(), "fignum_exists");
+    PyObject* margins = PyObject_GetAttrString(pyplot(), "margins");
+    PyObject* gca = PyObject_GetAttrString(pyplot(), "gca");
+
+    printf("%d calls each, ns/call\n", calls);
+    printf("%-18s %10s %10s %10s\n", "", "wrapper", "tuple", "lookup");
+
+    PyObject* main_module = PyImport_AddModule("__main__");
+    PyObject* globals = PyModule_GetDict(main_module);
+    check(PyRun_String("def noop(*args):\n    pass\n", Py_file_input, globals, globals));
+    PyObject* noop = PyObject_GetAttrString(main_module, "noop");
+    bench("noop(0.1)", calls,
+          [&] { check(plt::detail::call(noop, {PyFloat_FromDouble(0.1)})); },
+          [&] { tuple_call(noop, {PyFloat_FromDouble(0.1)}); },
+          [&] { lookup_call(main_module, "noop", {PyFloat_FromDouble(0.1)}); });
+
+    bench("xlim(0, 10)", calls,
+          [] { plt::xlim(0.0, 10.0); },
+          [&] { tuple_call(xlim, {pair(0.0, 10.0)}); },
+          [] { lookup_call(pyplot(), "xlim", {pair(0.0, 10.0)}); });
+    bench("xlim()", calls,
+          [] { plt::xlim(); },
+          [&] { tuple_call(xlim, {}); },
+          [] { lookup_call(pyplot(), "xlim", {}); });
+    bench("axis(\"on\")", calls,
+          [] { plt::axis("on"); },
+          [&] { tuple_call(axis, {PyString_FromString("on")}); },
+          [] { lookup_call(pyplot(), "axis", {PyString_FromString("on")}); });
+    bench("grid(true)", calls,
+          [] { plt::grid(true); },
+          [&] { Py_INCREF(Py_True); tuple_call(grid, {Py_True}); },
+          [] { Py_INCREF(Py_True); lookup_call(pyplot(), "grid", {Py_True}); });
+    bench("fignum_exists(1)", calls,
+          [] { plt::fignum_exists(1); },
+          [&] { tuple_call(fignum_exists, {PyInt_FromLong(1)}); },
+          [] { lookup_call(pyplot(), "fignum_exists", {PyInt_FromLong(1)}); });
+    bench("margins(0.1)", calls,
+          [] { plt::margins(0.1); },
+          [&] { tuple_call(margins, {PyFloat_FromDouble(0.1)}); },
+          [] { lookup_call(pyplot(), "margins", {PyFloat_FromDouble(0.1)}); });
+
+    // set_zlabel() needs 3d axes; the old path fetched gca and the bound
+    // method anew on every call
+    check(PyRun_String("import matplotlib.pyplot as plt\nplt.figure().add_subplot(projection='3d')\n",
+                       Py_file_input, globals, globals));
+    PyObject* ax = PyObject_CallObject(gca, NULL);
+    PyObject* set_zlabel = PyObject_GetAttrString(ax, "set_zlabel");
+    bench("set_zlabel(\"z\")", calls,
+          [] { plt::set_zlabel("z"); },
+          [&] { tuple_call(set_zlabel, {PyString_FromString("z")}); },
+          [] {
+              PyObject* gca = PyObject_GetAttrString(pyplot(), "gca");
+              PyObject* ax = PyObject_CallObject(gca, NULL);
+              lookup_call(ax, "set_zlabel", {PyString_FromString("z")});
+              Py_DECREF(ax);
+              Py_DECREF(gca);
+          });
+
+    Py_DECREF(set_zlabel);
+    Py_DECREF(ax);
+    Py_DECREF(gca);
+    Py_DECREF(margins);
+    Py_DECREF(fignum_exists);
+    Py_DECREF(grid);
+    Py_DECREF(axis);
+    Py_DECREF(xlim);
+    Py_DECREF(noop);
+}
@@ -0,0 +1,61 @@
+// Measures how fast element types without a numpy equivalent are widened to
+// double, on one thread and spread over all of them, for growing input
+// sizes. The sizes at which the threaded conversion pulls ahead are what
+// detail::parallel_min_chunk is chosen from.
+#include "../matplotlibcpp.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+// A user numeric wrapper, as found in unit libraries.
+struct Celsius {
+    float value;
+    explicit operator double() const { return value; }
+};
+
+template<typename Convert>
+double seconds_per_call(size_t n, const Convert& convert)
+{
+    // repeat small inputs so every measurement covers about 64M elements
+    const size_t repeats = std::max<size_t>(1, (size_t(1) << 26) / n);
+    convert();
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repeats; ++r)
+        convert();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count() / repeats;
+}
+
+template<typename Numeric, typename Make>
+void bench(const char* name, const Make& make)
+{
+    printf("%s (%zu bytes), GB/s read:\n", name, sizeof(Numeric));
+    printf("%12s %10s %10s\n", "elements", "serial", "threaded");
+    for (size_t n = size_t(1) << 12; n <= size_t(1) << 24; n <<= 2) {
+        std::vector<Numeric> src(n);
+        for (size_t i = 0; i < n; ++i)
+            src[i] = make(i % 100);
+        std::vector<double> dst(n);
+
+        const double serial = seconds_per_call(n, [&] {
+            plt::detail::convert_to_double_serial(src.data(), n, sizeof(Numeric), dst.data());
+        });
+        const double threaded = seconds_per_call(n, [&] {
+            plt::detail::convert_to_double(src.data(), n, sizeof(Numeric), dst.data());
+        });
+        const double bytes = double(n * sizeof(Numeric));
+        printf("%12zu %10.2f %10.2f\n", n, bytes / serial * 1e-9, bytes / threaded * 1e-9);
+    }
+}
+
+int main()
+{
+    printf("%zu hardware threads, parallel_min_chunk = %zu\n",
+           plt::detail::thread_count(), plt::detail::parallel_min_chunk);
+    bench<long>("long", [](size_t i) { return static_cast<long>(i); });
+    bench<char>("char", [](size_t i) { return static_cast<char>(i); });
+    bench<Celsius>("Celsius", [](size_t i) { return Celsius{static_cast<float>(i)}; });
+}
@@ -0,0 +1,60 @@
+// Measures how many bytes get_2darray() hands over to python per call for
+// grids of narrow element types, compared to widening them to double.
+#include "../matplotlibcpp.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+// The size of the buffer behind a python array, through the buffer protocol
+// so it works for numpy arrays and array.array alike.
+static size_t buffer_bytes(PyObject* array)
+{
+    Py_buffer view;
+    if (PyObject_GetBuffer(array, &view, PyBUF_SIMPLE) != 0) {
+        PyErr_Clear();
+        return 0;
+    }
+    size_t bytes = view.len;
+    PyBuffer_Release(&view);
+    return bytes;
+}
+
+template<typename Numeric>
+void bench(const char* name, size_t rows, size_t cols, int calls)
+{
+    std::vector<std::vector<Numeric>> grid(rows, std::vector<Numeric>(cols));
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            grid[i][j] = static_cast<Numeric>((i * 7 + j * 3) % 100);
+
+    size_t bytes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int c = 0; c < calls; ++c) {
+        PyObject* array = plt::detail::get_2darray(grid);
+        bytes = buffer_bytes(array);
+        Py_DECREF(array);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    const double widened = double(rows * cols * sizeof(double));
+    printf("%-8s %10.0f bytes/call as double, %10zu bytes/call now (%4.1fx less), %8.1f us/call\n",
+           name, widened, bytes, bytes ? widened / bytes : 0.0,
+           std::chrono::duration<double, std::micro>(t1 - t0).count() / calls);
+}
+
+int main()
+{
+    plt::detail::_interpreter::get();
+
+    const size_t rows = 1000, cols = 1000;
+    const int calls = 50;
+    printf("%zu x %zu grid, %d calls each\n", rows, cols, calls);
+    bench<double>("double", rows, cols, calls);
+    bench<float>("float", rows, cols, calls);
+    bench<int16_t>("int16", rows, cols, calls);
+    bench<uint8_t>("uint8", rows, cols, calls);
+}
@@ -0,0 +1,52 @@
+// Measures the time to the first plot, as a short-lived program sees it:
+// from entering main() to the interpreter being up, the first plot() and
+// the figure being saved. Afterwards pylab, which the interpreter no longer
+// imports on startup, is imported to show what it used to add.
+#include "../matplotlibcpp.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+typedef std::chrono::steady_clock clock_type;
+
+static double ms_since(clock_type::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+static void timed_import(const char* name)
+{
+    auto t0 = clock_type::now();
+    PyObject* module = PyImport_ImportModule(name);
+    const double ms = ms_since(t0);
+    if (!module) {
+        PyErr_Print();
+        return;
+    }
+    Py_DECREF(module);
+    printf("  import %-10s%8.1f ms\n", name, ms);
+}
+
+int main()
+{
+    const auto start = clock_type::now();
+
+    plt::detail::_interpreter::get();
+    const double interpreter = ms_since(start);
+
+    plt::plot(std::vector<double>{1.0, 3.0, 2.0, 4.0});
+    const double plotted = ms_since(start);
+
+    plt::save("startup.png");
+    const double saved = ms_since(start);
+
+    printf("since main():\n");
+    printf("  interpreter up   %8.1f ms\n", interpreter);
+    printf("  first plot()     %8.1f ms\n", plotted);
+    printf("  save()           %8.1f ms\n", saved);
+    printf("no longer imported on startup:\n");
+    timed_import("pylab");
+}
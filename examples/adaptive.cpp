@@ -0,0 +1,21 @@
+#include "../matplotlibcpp.h"
+
+#include <cmath>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+int main()
+{
+    // Samples are placed where the curve needs them: the flat parts take
+    // few evaluations and the sharp peak is still resolved.
+    plt::plot([](double x) { return std::exp(-x * x * 400) + 0.1 * std::sin(x); }, -5.0, 5.0, "r-");
+
+    // A fixed set of ticks evaluated on all hardware threads.
+    std::vector<double> ticks(100000);
+    for (size_t i = 0; i < ticks.size(); ++i)
+        ticks[i] = -5 + 10.0 * i / ticks.size();
+    plt::plot(plt::parallel, ticks, [](double x) { return 0.5 * std::cos(3 * x); }, "b-");
+
+    plt::show();
+}
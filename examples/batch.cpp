@@ -0,0 +1,33 @@
+#include "../matplotlibcpp.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+int main()
+{
+    // A dashboard of many small series. Inside the Batch scope the calls are
+    // only recorded, and submit() replays all of them in one trip to python.
+    const int series = 50, n = 200;
+    std::vector<double> x(n);
+    for (int i = 0; i < n; ++i)
+        x[i] = i * 0.05;
+
+    {
+        plt::Batch batch;
+        for (int s = 0; s < series; ++s) {
+            std::vector<double> y(n);
+            for (int i = 0; i < n; ++i)
+                y[i] = std::sin(x[i] + 0.1 * s) + 0.05 * s;
+            // y goes out of scope before the batch runs, so it's moved in
+            plt::plot(x, std::move(y), {{"linewidth", 0.5}, {"color", "tab:blue"}});
+        }
+        plt::title("50 series, one call into python");
+        plt::xlabel("t");
+        batch.submit(); // throws if any recorded call failed
+    }
+
+    plt::show();
+}
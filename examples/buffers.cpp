@@ -0,0 +1,48 @@
+#include "../matplotlibcpp.h"
+
+#include <memory>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+struct Sample {
+    double time;
+    float value;
+    int flags;
+};
+
+int main()
+{
+    std::vector<Sample> log(1000);
+    for (size_t i = 0; i < log.size(); ++i)
+        log[i] = {i * 0.01, static_cast<float>((i % 100) * 0.01), 0};
+
+    // Members of an array of structs are plotted in place through a stride.
+    plt::plot(&log[0].time, &log[0].value, log.size(), "b-", sizeof(Sample), sizeof(Sample));
+
+    // The same with keywords; every other record, shifted down.
+    std::vector<Sample> shifted(log);
+    for (Sample& s : shifted)
+        s.value -= 0.25f;
+    plt::plot(&shifted[0].time, &shifted[0].value, shifted.size() / 2,
+              plt::Keywords{{"color", "k"}, {"linestyle", ":"}}, 2 * sizeof(Sample), 2 * sizeof(Sample));
+
+    // A moved vector is handed to numpy without a copy...
+    std::vector<double> t(1000), u(1000);
+    for (size_t i = 0; i < t.size(); ++i) {
+        t[i] = i * 0.01;
+        u[i] = 1 - (i % 100) * 0.01;
+    }
+    plt::plot(std::move(t), std::move(u), "g-");
+
+    // ...and a shared one stays alive for as long as matplotlib uses it.
+    auto st = std::make_shared<std::vector<double>>(1000);
+    auto su = std::make_shared<std::vector<double>>(1000);
+    for (size_t i = 0; i < st->size(); ++i) {
+        (*st)[i] = i * 0.01;
+        (*su)[i] = 0.5;
+    }
+    plt::plot(st, su, "r--");
+
+    plt::show();
+}
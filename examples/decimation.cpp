@@ -0,0 +1,60 @@
+#include "../matplotlibcpp.h"
+
+#include <cmath>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+int main()
+{
+    const size_t n = 5000000;
+    std::vector<double> x(n), y(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = i * 1e-4;
+        y[i] = std::sin(x[i]) + 0.2 * std::sin(x[i] * 97.0);
+    }
+
+    // Only about four points per pixel column reach matplotlib, and the line
+    // looks the same as with all of them.
+    plt::set_decimation(plt::Decimation::M4);
+    plt::subplot(3, 1, 1);
+    plt::plot(x, y);
+    plt::title("M4 decimation");
+
+    // With fixed x limits only the visible slice of the ascending x is sent,
+    // and zooming later re-decimates it from a kept copy.
+    plt::set_viewport_culling(true);
+    plt::set_interactive_decimation(true);
+    plt::subplot(3, 1, 2);
+    plt::xlim(100.0, 110.0);
+    plt::plot(x, y);
+
+    // x that is not ascending can't be searched, so such a series is passed
+    // on whole instead of culled.
+    std::vector<double> ux(50), uy(50);
+    for (size_t i = 0; i < ux.size(); ++i) {
+        ux[i] = 100 + std::fmod(i * 3.7, 10.0);
+        uy[i] = 0.5 * std::cos(i * 0.4);
+    }
+    plt::plot(ux, uy, "r.");
+    plt::title("culled to 100 <= x <= 110");
+
+    // Simplification drops vertices that move the path by less than a
+    // quarter pixel, for curves that are not plotted against a sorted x.
+    plt::set_decimation(plt::Decimation::None);
+    plt::set_viewport_culling(false);
+    plt::set_interactive_decimation(false);
+    plt::set_simplification(plt::Simplification::RDP, 0.25);
+    std::vector<double> cx(200000), cy(200000);
+    for (size_t i = 0; i < cx.size(); ++i) {
+        const double t = 2 * M_PI * i / cx.size();
+        cx[i] = std::cos(t) * (1 + 0.1 * std::cos(12 * t));
+        cy[i] = std::sin(t) * (1 + 0.1 * std::cos(12 * t));
+    }
+    plt::subplot(3, 1, 3);
+    plt::plot(cx, cy);
+    plt::title("simplified outline");
+
+    plt::tight_layout();
+    plt::show();
+}
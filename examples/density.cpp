@@ -0,0 +1,41 @@
+#include "../matplotlibcpp.h"
+
+#include <random>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+int main()
+{
+    std::mt19937 gen(1);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    const size_t n = 2000000;
+    std::vector<double> x(n), y(n), v(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = normal(gen);
+        y[i] = 0.5 * x[i] + normal(gen);
+        v[i] = x[i] * y[i];
+    }
+
+    // Far too many points for one marker each: they are counted per pixel
+    // in C++ and shown as an image.
+    plt::subplot(2, 2, 1);
+    plt::scatter_density(x, y, plt::DensityNorm::Log);
+    plt::title("scatter_density, counts");
+
+    plt::subplot(2, 2, 2);
+    plt::scatter_density(x, y, v, plt::Aggregate::Mean);
+    plt::title("scatter_density, mean of x*y");
+
+    plt::subplot(2, 2, 3);
+    plt::hist2d(x, y, 50, 50);
+    plt::title("hist2d");
+
+    plt::subplot(2, 2, 4);
+    plt::hexbin(x, y, 40, plt::DensityNorm::Log);
+    plt::title("hexbin");
+
+    plt::tight_layout();
+    plt::show();
+}
@@ -0,0 +1,37 @@
+#include "../matplotlibcpp.h"
+
+#include <random>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+int main()
+{
+    std::mt19937 gen(42);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    // Values are binned in C++ as they stream in; only the edges and the
+    // counts are handed to matplotlib.
+    plt::Histogram h = plt::Histogram::linear(60, -4.0, 4.0);
+    std::vector<double> chunk(100000);
+    for (int c = 0; c < 20; ++c) {
+        for (double& v : chunk)
+            v = normal(gen);
+        h.add(chunk);
+    }
+
+    plt::subplot(1, 2, 1);
+    plt::named_hist("2M samples", h, "tab:blue", 0.7);
+    plt::hist(chunk, 60, "tab:orange", 0.7);
+    plt::legend();
+
+    // Box statistics are computed in C++ as well and drawn with Axes.bxp().
+    std::vector<std::vector<double>> groups(4, std::vector<double>(50000));
+    for (size_t g = 0; g < groups.size(); ++g)
+        for (double& v : groups[g])
+            v = normal(gen) * (g + 1);
+
+    plt::subplot(1, 2, 2);
+    plt::boxplot(groups, {"a", "b", "c", "d"}, {}, 20);
+    plt::show();
+}
@@ -0,0 +1,32 @@
+#include "../matplotlibcpp.h"
+
+#include <cmath>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+int main()
+{
+    // An 8k x 8k single channel image. The pyramid halves it again and again
+    // once, and imshow() then sends only the level that matches the axes.
+    const size_t rows = 8192, cols = 8192;
+    std::vector<float> image(rows * cols);
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            image[i * cols + j] = std::sin(i * 0.01f) * std::cos(j * 0.013f);
+
+    plt::ImagePyramid<float> pyramid(image.data(), rows, cols);
+
+    plt::subplot(1, 2, 1);
+    plt::imshow(pyramid, {{"cmap", "viridis"}});
+    plt::title("whole image");
+
+    // With limits set, the level is cropped to them before it is sent.
+    plt::subplot(1, 2, 2);
+    plt::xlim(1000, 1500);
+    plt::ylim(1500, 1000);
+    plt::imshow(pyramid, {{"cmap", "viridis"}});
+    plt::title("zoomed in");
+
+    plt::show();
+}
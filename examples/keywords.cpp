@@ -0,0 +1,29 @@
+#include "../matplotlibcpp.h"
+
+#include <cmath>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+int main()
+{
+    std::vector<double> x(100), y(100), sizes(100);
+    for (int i = 0; i < 100; ++i) {
+        x[i] = i;
+        y[i] = std::sin(i * 0.1);
+        sizes[i] = 5 + i;
+    }
+
+    // A Keywords object is turned into a python dictionary once, on first
+    // use, and that dictionary is reused every time the object is passed.
+    const plt::Keywords guide = {{"color", "gray"}, {"linestyle", "--"}};
+    for (int i = 0; i < 10; ++i)
+        plt::axvline(i * 10, 0., 1., guide);
+
+    // Keyword values can be strings, numbers, bools or arrays.
+    const plt::Keywords style = {{"color", "tab:red"}, {"linewidth", 2}, {"antialiased", true}};
+    plt::plot(x, y, style);
+    plt::scatter(x, y, 1.0, {{"s", plt::KeywordValue(sizes)}, {"zorder", 3}});
+    plt::title("Keywords", {{"fontsize", 14}});
+    plt::show();
+}
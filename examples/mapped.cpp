@@ -0,0 +1,29 @@
+#include "../matplotlibcpp.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+int main()
+{
+    // Write a raw file of float samples, as a data logger would.
+    const char* path = "mapped_samples.f32";
+    std::vector<float> samples(1000000);
+    for (size_t i = 0; i < samples.size(); ++i)
+        samples[i] = std::sin(i * 1e-4f) * std::exp(-i * 2e-6f);
+    FILE* f = std::fopen(path, "wb");
+    if (!f) return 1;
+    std::fwrite(samples.data(), sizeof(float), samples.size(), f);
+    std::fclose(f);
+
+    // The file is memory-mapped by numpy and plotted without reading it
+    // into C++ first.
+    plt::MappedArray y(path, "<f4");
+    plt::plot(y);
+    plt::title("memory-mapped samples");
+    plt::show();
+
+    std::remove(path);
+}
@@ -0,0 +1,27 @@
+#include "../matplotlibcpp.h"
+
+#include <cmath>
+#include <vector>
+
+namespace plt = matplotlibcpp;
+
+int main()
+{
+    // A 1000 x 1000 grid has far more cells than the figure can show.
+    const size_t n = 1000;
+    std::vector<double> x(n * n), y(n * n), z(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            const double u = -5 + 10.0 * i / (n - 1), v = -5 + 10.0 * j / (n - 1);
+            x[i * n + j] = u;
+            y[i * n + j] = v;
+            z[i * n + j] = std::exp(-(u * u + v * v)) * 3 + std::sin(std::hypot(u, v));
+        }
+    }
+
+    // Adaptive picks more rows and columns where the surface bends strongly,
+    // up to about one polygon per 6 x 6 pixels of the figure.
+    plt::set_surface_lod(plt::SurfaceLOD::Adaptive);
+    plt::plot_surface(x.data(), y.data(), z.data(), n, n);
+    plt::show();
+}
@@ -6,14 +6,24 @@
 
 #include <vector>
 #include <map>
+#include <initializer_list>
 #include <array>
 #include <numeric>
 #include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <cstdint> // <cstdint> requires c++11 support
+#include <cstddef> // std::ptrdiff_t
+#include <cmath>
 #include <functional>
+#include <iterator>
+#include <type_traits>
+#include <memory>
 #include <string> // std::stod
+#ifndef WITHOUT_THREADS
+#  include <thread>
+#  include <exception>
+#endif
 
 #ifndef WITHOUT_NUMPY
 #  define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
@@ -37,6 +47,7 @@
 #  define PyString_FromString PyUnicode_FromString
 #  define PyInt_FromLong PyLong_FromLong
 #  define PyString_FromString PyUnicode_FromString
+#  define PyString_InternFromString PyUnicode_InternFromString
 #endif
 
 
@@ -45,64 +56,113 @@ namespace detail {
 
 static std::string s_backend;
 
+// A function of matplotlib.pyplot, looked up the first time it is used so
+// that starting the interpreter doesn't pay for the ones never called.
+// Converts to a borrowed reference and throws if pyplot lacks a required
+// function. Lookups that aren't required are not checked to be functions
+// and come back NULL when missing.
+class pyplot_function {
+public:
+    explicit pyplot_function(const char* name, bool required = true)
+        : name_(name), required_(required), fn_(nullptr), resolved_(false) {}
+
+    pyplot_function(const pyplot_function&) = delete;
+    pyplot_function& operator=(const pyplot_function&) = delete;
+
+    operator PyObject*() const;
+
+private:
+    const char* name_;
+    bool required_;
+    mutable PyObject* fn_;
+    mutable bool resolved_;
+};
+
+// The bound methods axes_method() looked up, for the one axes they belong
+// to. Each of them keeps that axes alive, so the cache is released
+// whenever figures go away and before the interpreter is finalized.
+struct axes_method_cache {
+    PyObject* axes;
+    std::map<std::string, PyObject*> methods;
+};
+
+inline axes_method_cache& axes_methods()
+{
+    // never destroyed, so nothing is released after Py_Finalize
+    static axes_method_cache* cache = new axes_method_cache();
+    return *cache;
+}
+
+inline void release_axes_methods()
+{
+    axes_method_cache& cache = axes_methods();
+    if (Py_IsInitialized()) {
+        for (auto& method : cache.methods)
+            Py_DECREF(method.second);
+        Py_XDECREF(cache.axes);
+    }
+    cache.methods.clear();
+    cache.axes = nullptr;
+}
+
 struct _interpreter {
-    PyObject* s_python_function_arrow;
-    PyObject *s_python_function_show;
-    PyObject *s_python_function_close;
-    PyObject *s_python_function_draw;
-    PyObject *s_python_function_pause;
-    PyObject *s_python_function_save;
-    PyObject *s_python_function_figure;
-    PyObject *s_python_function_fignum_exists;
-    PyObject *s_python_function_plot;
-    PyObject *s_python_function_quiver;
-    PyObject* s_python_function_contour;
-    PyObject *s_python_function_semilogx;
-    PyObject *s_python_function_semilogy;
-    PyObject *s_python_function_loglog;
-    PyObject *s_python_function_fill;
-    PyObject *s_python_function_fill_between;
-    PyObject *s_python_function_hist;
-    PyObject *s_python_function_imshow;
-    PyObject *s_python_function_scatter;
-    PyObject *s_python_function_boxplot;
-    PyObject *s_python_function_subplot;
-    PyObject *s_python_function_subplot2grid;
-    PyObject *s_python_function_legend;
-    PyObject *s_python_function_xlim;
-    PyObject *s_python_function_ion;
-    PyObject *s_python_function_ginput;
-    PyObject *s_python_function_ylim;
-    PyObject *s_python_function_title;
-    PyObject *s_python_function_axis;
-    PyObject *s_python_function_axhline;
-    PyObject *s_python_function_axvline;
-    PyObject *s_python_function_axvspan;
-    PyObject *s_python_function_xlabel;
-    PyObject *s_python_function_ylabel;
-    PyObject *s_python_function_gca;
-    PyObject *s_python_function_xticks;
-    PyObject *s_python_function_yticks;
-    PyObject* s_python_function_margins;
-    PyObject *s_python_function_tick_params;
-    PyObject *s_python_function_grid;
-    PyObject* s_python_function_cla;
-    PyObject *s_python_function_clf;
-    PyObject *s_python_function_errorbar;
-    PyObject *s_python_function_annotate;
-    PyObject *s_python_function_tight_layout;
-    PyObject *s_python_colormap;
-    PyObject *s_python_empty_tuple;
-    PyObject *s_python_function_stem;
-    PyObject *s_python_function_xkcd;
-    PyObject *s_python_function_text;
-    PyObject *s_python_function_suptitle;
-    PyObject *s_python_function_bar;
-    PyObject *s_python_function_barh;
-    PyObject *s_python_function_colorbar;
-    PyObject *s_python_function_subplots_adjust;
-    PyObject *s_python_function_rcparams;
-    PyObject *s_python_function_spy;
+    PyObject *s_python_module_pyplot;
+    pyplot_function s_python_function_arrow{"arrow"};
+    pyplot_function s_python_function_show{"show"};
+    pyplot_function s_python_function_close{"close"};
+    pyplot_function s_python_function_draw{"draw"};
+    pyplot_function s_python_function_pause{"pause"};
+    pyplot_function s_python_function_save{"savefig"};
+    pyplot_function s_python_function_figure{"figure"};
+    pyplot_function s_python_function_fignum_exists{"fignum_exists"};
+    pyplot_function s_python_function_plot{"plot"};
+    pyplot_function s_python_function_quiver{"quiver"};
+    pyplot_function s_python_function_contour{"contour"};
+    pyplot_function s_python_function_semilogx{"semilogx"};
+    pyplot_function s_python_function_semilogy{"semilogy"};
+    pyplot_function s_python_function_loglog{"loglog"};
+    pyplot_function s_python_function_fill{"fill"};
+    pyplot_function s_python_function_fill_between{"fill_between"};
+    pyplot_function s_python_function_imshow{"imshow"};
+    pyplot_function s_python_function_scatter{"scatter"};
+    pyplot_function s_python_function_subplot{"subplot"};
+    pyplot_function s_python_function_subplot2grid{"subplot2grid"};
+    pyplot_function s_python_function_legend{"legend"};
+    pyplot_function s_python_function_xlim{"xlim"};
+    pyplot_function s_python_function_ion{"ion"};
+    pyplot_function s_python_function_ginput{"ginput"};
+    pyplot_function s_python_function_ylim{"ylim"};
+    pyplot_function s_python_function_title{"title"};
+    pyplot_function s_python_function_axis{"axis"};
+    pyplot_function s_python_function_axhline{"axhline"};
+    pyplot_function s_python_function_axvline{"axvline"};
+    pyplot_function s_python_function_axvspan{"axvspan"};
+    pyplot_function s_python_function_xlabel{"xlabel"};
+    pyplot_function s_python_function_ylabel{"ylabel"};
+    pyplot_function s_python_function_gca{"gca"};
+    pyplot_function s_python_function_xticks{"xticks"};
+    pyplot_function s_python_function_yticks{"yticks"};
+    pyplot_function s_python_function_margins{"margins"};
+    pyplot_function s_python_function_tick_params{"tick_params"};
+    pyplot_function s_python_function_grid{"grid"};
+    pyplot_function s_python_function_cla{"cla"};
+    pyplot_function s_python_function_clf{"clf"};
+    pyplot_function s_python_function_errorbar{"errorbar"};
+    pyplot_function s_python_function_annotate{"annotate"};
+    pyplot_function s_python_function_tight_layout{"tight_layout"};
+    PyObject *s_python_array_type;
+    PyObject *s_python_function_frombuffer;
+    pyplot_function s_python_function_stem{"stem"};
+    pyplot_function s_python_function_xkcd{"xkcd"};
+    pyplot_function s_python_function_text{"text"};
+    pyplot_function s_python_function_suptitle{"suptitle"};
+    pyplot_function s_python_function_bar{"bar"};
+    pyplot_function s_python_function_stairs{"stairs", false}; // new in matplotlib 3.4
+    pyplot_function s_python_function_barh{"barh"};
+    pyplot_function s_python_function_colorbar{"colorbar"};
+    pyplot_function s_python_function_subplots_adjust{"subplots_adjust"};
+    pyplot_function s_python_function_rcparams{"rcParams", false};
+    pyplot_function s_python_function_spy{"spy"};
 
     /* For now, _interpreter is implemented as a singleton since its currently not possible to have
        multiple independent embedded python interpreters without patching the python source code
@@ -190,9 +250,7 @@ private:
 
         PyObject* matplotlibname = PyString_FromString("matplotlib");
         PyObject* pyplotname = PyString_FromString("matplotlib.pyplot");
-        PyObject* cmname  = PyString_FromString("matplotlib.cm");
-        PyObject* pylabname  = PyString_FromString("pylab");
-        if (!pyplotname || !pylabname || !matplotlibname || !cmname) {
+        if (!pyplotname || !matplotlibname) {
             throw std::runtime_error("couldnt create string");
         }
 
@@ -204,93 +262,404 @@ private:
             throw std::runtime_error("Error loading module matplotlib!");
         }
 
-        // matplotlib.use() must be called *before* pylab, matplotlib.pyplot,
+        // matplotlib.use() must be called *before* matplotlib.pyplot
         // or matplotlib.backends is imported for the first time
         if (!s_backend.empty()) {
             PyObject_CallMethod(matplotlib, const_cast<char*>("use"), const_cast<char*>("s"), s_backend.c_str());
         }
 
+        // the pyplot functions themselves are looked up on first use
+        s_python_module_pyplot = PyImport_Import(pyplotname);
+        Py_DECREF(pyplotname);
+        if (!s_python_module_pyplot) { throw std::runtime_error("Error loading module matplotlib.pyplot!"); }
+#ifdef WITHOUT_NUMPY
+        // Without the numpy C-API the data is handed over in array.array
+        // buffers. numpy itself is still there at runtime, since matplotlib
+        // depends on it, and is used to give 2d grids their shape.
+        PyObject* arrayname = PyString_FromString("array");
+        PyObject* numpyname = PyString_FromString("numpy");
+        if (!arrayname || !numpyname) {
+            throw std::runtime_error("couldnt create string");
+        }
+
+        PyObject* arraymod = PyImport_Import(arrayname);
+        Py_DECREF(arrayname);
+        if (!arraymod) { throw std::runtime_error("Error loading module array!"); }
 
+        PyObject* numpymod = PyImport_Import(numpyname);
+        Py_DECREF(numpyname);
+        if (!numpymod) { throw std::runtime_error("Error loading module numpy!"); }
 
-        PyObject* pymod = PyImport_Import(pyplotname);
-        Py_DECREF(pyplotname);
-        if (!pymod) { throw std::runtime_error("Error loading module matplotlib.pyplot!"); }
-
-        s_python_colormap = PyImport_Import(cmname);
-        Py_DECREF(cmname);
-        if (!s_python_colormap) { throw std::runtime_error("Error loading module matplotlib.cm!"); }
-
-        PyObject* pylabmod = PyImport_Import(pylabname);
-        Py_DECREF(pylabname);
-        if (!pylabmod) { throw std::runtime_error("Error loading module pylab!"); }
-
-        s_python_function_arrow = safe_import(pymod, "arrow");
-        s_python_function_show = safe_import(pymod, "show");
-        s_python_function_close = safe_import(pymod, "close");
-        s_python_function_draw = safe_import(pymod, "draw");
-        s_python_function_pause = safe_import(pymod, "pause");
-        s_python_function_figure = safe_import(pymod, "figure");
-        s_python_function_fignum_exists = safe_import(pymod, "fignum_exists");
-        s_python_function_plot = safe_import(pymod, "plot");
-        s_python_function_quiver = safe_import(pymod, "quiver");
-        s_python_function_contour = safe_import(pymod, "contour");
-        s_python_function_semilogx = safe_import(pymod, "semilogx");
-        s_python_function_semilogy = safe_import(pymod, "semilogy");
-        s_python_function_loglog = safe_import(pymod, "loglog");
-        s_python_function_fill = safe_import(pymod, "fill");
-        s_python_function_fill_between = safe_import(pymod, "fill_between");
-        s_python_function_hist = safe_import(pymod,"hist");
-        s_python_function_scatter = safe_import(pymod,"scatter");
-        s_python_function_boxplot = safe_import(pymod,"boxplot");
-        s_python_function_subplot = safe_import(pymod, "subplot");
-        s_python_function_subplot2grid = safe_import(pymod, "subplot2grid");
-        s_python_function_legend = safe_import(pymod, "legend");
-        s_python_function_xlim = safe_import(pymod, "xlim");
-        s_python_function_ylim = safe_import(pymod, "ylim");
-        s_python_function_title = safe_import(pymod, "title");
-        s_python_function_axis = safe_import(pymod, "axis");
-        s_python_function_axhline = safe_import(pymod, "axhline");
-        s_python_function_axvline = safe_import(pymod, "axvline");
-        s_python_function_axvspan = safe_import(pymod, "axvspan");
-        s_python_function_xlabel = safe_import(pymod, "xlabel");
-        s_python_function_ylabel = safe_import(pymod, "ylabel");
-        s_python_function_gca = safe_import(pymod, "gca");
-        s_python_function_xticks = safe_import(pymod, "xticks");
-        s_python_function_yticks = safe_import(pymod, "yticks");
-        s_python_function_margins = safe_import(pymod, "margins");
-        s_python_function_tick_params = safe_import(pymod, "tick_params");
-        s_python_function_grid = safe_import(pymod, "grid");
-        s_python_function_ion = safe_import(pymod, "ion");
-        s_python_function_ginput = safe_import(pymod, "ginput");
-        s_python_function_save = safe_import(pylabmod, "savefig");
-        s_python_function_annotate = safe_import(pymod,"annotate");
-        s_python_function_cla = safe_import(pymod, "cla");
-        s_python_function_clf = safe_import(pymod, "clf");
-        s_python_function_errorbar = safe_import(pymod, "errorbar");
-        s_python_function_tight_layout = safe_import(pymod, "tight_layout");
-        s_python_function_stem = safe_import(pymod, "stem");
-        s_python_function_xkcd = safe_import(pymod, "xkcd");
-        s_python_function_text = safe_import(pymod, "text");
-        s_python_function_suptitle = safe_import(pymod, "suptitle");
-        s_python_function_bar = safe_import(pymod,"bar");
-        s_python_function_barh = safe_import(pymod, "barh");
-        s_python_function_colorbar = PyObject_GetAttrString(pymod, "colorbar");
-        s_python_function_subplots_adjust = safe_import(pymod,"subplots_adjust");
-        s_python_function_rcparams = PyObject_GetAttrString(pymod, "rcParams");
-	s_python_function_spy = PyObject_GetAttrString(pymod, "spy");
-#ifndef WITHOUT_NUMPY
-        s_python_function_imshow = safe_import(pymod, "imshow");
+        s_python_array_type = PyObject_GetAttrString(arraymod, "array");
+        s_python_function_frombuffer = PyObject_GetAttrString(numpymod, "frombuffer");
+        if (!s_python_array_type || !s_python_function_frombuffer) {
+            throw std::runtime_error("Couldn't find array.array or numpy.frombuffer");
+        }
 #endif
-        s_python_empty_tuple = PyTuple_New(0);
     }
 
     ~_interpreter() {
+        release_axes_methods();
         Py_Finalize();
     }
 };
 
+inline pyplot_function::operator PyObject*() const
+{
+    if (!resolved_) {
+        PyObject* pyplot = _interpreter::get().s_python_module_pyplot;
+        if (required_) {
+            fn_ = _interpreter::get().safe_import(pyplot, name_);
+        } else {
+            fn_ = PyObject_GetAttrString(pyplot, name_);
+            if (!fn_) PyErr_Clear();
+        }
+        resolved_ = true;
+    }
+    return fn_;
+}
+
+// A call recorded by an open Batch, holding a reference to the callable
+// and to each of its arguments. kwargs may be NULL.
+struct command {
+    PyObject* fn;
+    PyObject* args;
+    PyObject* kwargs;
+};
+
+// The commands recorded since the outermost Batch was opened, or NULL
+// while no batch is open.
+inline std::vector<command>*& batch_buffer()
+{
+    static std::vector<command>* buffer = nullptr;
+    return buffer;
+}
+
+#ifndef WITHOUT_NUMPY
+// Whether o is an ndarray that, directly or through the arrays it is a
+// view of, points into memory the caller still owns.
+inline bool borrows_memory(PyObject* o)
+{
+    while (PyArray_Check(o)) {
+        PyArrayObject* array = reinterpret_cast<PyArrayObject*>(o);
+        if (PyArray_CHKFLAGS(array, NPY_ARRAY_OWNDATA))
+            return false;
+        o = PyArray_BASE(array);
+        if (!o)
+            return true;
+    }
+    return false;
+}
+#endif
+
+// Returns a new reference to o in which every array that borrows the
+// caller's memory is replaced by a copy, since a recorded call may only run
+// after that memory is gone. Tuples, lists and dicts are searched as well
+// and only copied when one of their items changes.
+inline PyObject* detach(PyObject* o)
+{
+#ifndef WITHOUT_NUMPY
+    if (borrows_memory(o)) {
+        PyObject* copy = PyArray_NewCopy(reinterpret_cast<PyArrayObject*>(o), NPY_KEEPORDER);
+        if (!copy) throw std::runtime_error("Couldn't copy an array for a batched call.");
+        return copy;
+    }
+#endif
+    const bool tuple = PyTuple_Check(o);
+    if (tuple || PyList_Check(o)) {
+        const Py_ssize_t n = PySequence_Fast_GET_SIZE(o);
+        PyObject* copy = NULL;
+        for (Py_ssize_t i = 0; i < n; ++i) {
+            PyObject* item = PySequence_Fast_GET_ITEM(o, i);
+            PyObject* detached = detach(item);
+            if (detached == item && !copy) {
+                Py_DECREF(detached);
+                continue;
+            }
+            if (!copy) {
+                copy = tuple ? PyTuple_New(n) : PyList_New(n);
+                for (Py_ssize_t j = 0; j < i; ++j) {
+                    PyObject* kept = PySequence_Fast_GET_ITEM(o, j);
+                    Py_INCREF(kept);
+                    if (tuple) PyTuple_SET_ITEM(copy, j, kept);
+                    else PyList_SET_ITEM(copy, j, kept);
+                }
+            }
+            if (tuple) PyTuple_SET_ITEM(copy, i, detached);
+            else PyList_SET_ITEM(copy, i, detached);
+        }
+        if (copy)
+            return copy;
+    } else if (PyDict_Check(o)) {
+        PyObject* copy = NULL;
+        PyObject* key;
+        PyObject* value;
+        Py_ssize_t pos = 0;
+        while (PyDict_Next(o, &pos, &key, &value)) {
+            PyObject* detached = detach(value);
+            if (detached != value) {
+                if (!copy) copy = PyDict_Copy(o);
+                PyDict_SetItem(copy, key, detached);
+            }
+            Py_DECREF(detached);
+        }
+        if (copy)
+            return copy;
+    }
+    Py_INCREF(o);
+    return o;
+}
+
+// The python side of a batch: runs every recorded call, also past failing
+// ones, and returns one line per failure or an empty string.
+inline PyObject* batch_executor()
+{
+    static PyObject* run = nullptr;
+    if (!run) {
+        const char* source =
+            "def run(commands):\n"
+            "    failed = []\n"
+            "    for i, (fn, args, kwargs) in enumerate(commands):\n"
+            "        try:\n"
+            "            fn(*args, **(kwargs or {}))\n"
+            "        except Exception as e:\n"
+            "            failed.append('Call to %s() failed (batched call %d of %d): %s: %s'\n"
+            "                          % (getattr(fn, '__name__', fn), i + 1, len(commands),\n"
+            "                             type(e).__name__, e))\n"
+            "    return '\\n'.join(failed)\n";
+
+        PyObject* globals = PyDict_New();
+        PyDict_SetItemString(globals, "__builtins__", PyEval_GetBuiltins());
+        PyObject* res = PyRun_String(source, Py_file_input, globals, globals);
+        if (res) {
+            Py_DECREF(res);
+            run = PyDict_GetItemString(globals, "run");
+            Py_XINCREF(run);
+        }
+        Py_DECREF(globals);
+        if (!run) throw std::runtime_error("Couldn't set up the batch executor.");
+    }
+    return run;
+}
+
+// Replays the commands recorded so far in a single call into python.
+inline void flush_batch()
+{
+    std::vector<command>* buffer = batch_buffer();
+    if (!buffer || buffer->empty())
+        return;
+
+    PyObject* commands = PyList_New(buffer->size());
+    for (size_t i = 0; i < buffer->size(); ++i) {
+        command& c = (*buffer)[i];
+        PyList_SET_ITEM(commands, i, PyTuple_Pack(3, c.fn, c.args, c.kwargs ? c.kwargs : Py_None));
+        Py_DECREF(c.fn);
+        Py_DECREF(c.args);
+        Py_XDECREF(c.kwargs);
+    }
+    buffer->clear();
+
+    PyObject* failed = PyObject_CallFunctionObjArgs(batch_executor(), commands, NULL);
+    Py_DECREF(commands);
+    if (!failed) throw std::runtime_error("Couldn't replay the batched calls.");
+
+#if PY_MAJOR_VERSION >= 3
+    const char* message = PyUnicode_AsUTF8(failed);
+#else
+    const char* message = PyString_AsString(failed);
+#endif
+    std::string errors = message ? message : "";
+    Py_DECREF(failed);
+    if (!errors.empty())
+        throw std::runtime_error(errors);
+}
+
+// Positional arguments of a call, kept on the stack. The call steals
+// the references; a NULL among them, e.g. from a failed conversion, makes
+// the call fail with that python error.
+typedef std::initializer_list<PyObject*> arguments;
+
+// Packs the nargs arguments in args into a new tuple, stealing them.
+inline PyObject* pack(PyObject* const* args, size_t nargs)
+{
+    PyObject* tuple = PyTuple_New(nargs);
+    for (size_t i = 0; i < nargs; ++i) {
+        if (!args[i]) {
+            Py_DECREF(tuple);
+            for (size_t j = i + 1; j < nargs; ++j)
+                Py_XDECREF(args[j]);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(tuple, i, args[i]);
+    }
+    return tuple;
+}
+
+// Calls fn(*args, **kwargs) without a batch in the way. Python 3.9 and up
+// take the arguments straight from the stack through vectorcall; older
+// versions get them packed into a tuple.
+inline PyObject* invoke(PyObject* fn, PyObject* const* args, size_t nargs, PyObject* kwargs)
+{
+#if PY_VERSION_HEX >= 0x03090000
+    bool complete = true;
+    for (size_t i = 0; i < nargs; ++i)
+        complete = complete && args[i];
+
+    PyObject* res = complete ? PyObject_VectorcallDict(fn, args, nargs, kwargs) : NULL;
+    for (size_t i = 0; i < nargs; ++i)
+        Py_XDECREF(args[i]);
+    return res;
+#else
+    PyObject* tuple = pack(args, nargs);
+    if (!tuple)
+        return NULL;
+    PyObject* res = PyObject_Call(fn, tuple, kwargs);
+    Py_DECREF(tuple);
+    return res;
+#endif
+}
+
+// Calls fn(*args, **kwargs), unless a Batch is open: then the call is
+// recorded and None stands in for its result. For calls whose result is
+// only checked for errors. kwargs is borrowed and may be NULL.
+inline PyObject* call(PyObject* fn, PyObject* const* args, size_t nargs, PyObject* kwargs = NULL)
+{
+    std::vector<command>* buffer = batch_buffer();
+    if (!buffer)
+        return invoke(fn, args, nargs, kwargs);
+
+    PyObject* tuple = pack(args, nargs);
+    if (!tuple)
+        return NULL;
+    command c = {fn, detach(tuple), kwargs ? detach(kwargs) : NULL};
+    Py_DECREF(tuple);
+    Py_INCREF(fn);
+    buffer->push_back(c);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+inline PyObject* call(PyObject* fn, arguments args, PyObject* kwargs = NULL)
+{
+    return call(fn, args.begin(), args.size(), kwargs);
+}
+
+// Calls fn(*args, **kwargs) right away, for calls whose result is needed.
+// Whatever an open Batch recorded is replayed first, so the call sees the
+// figures and axes those commands leave behind.
+inline PyObject* call_now(PyObject* fn, PyObject* const* args, size_t nargs, PyObject* kwargs = NULL)
+{
+    try {
+        flush_batch();
+    } catch (...) {
+        for (size_t i = 0; i < nargs; ++i)
+            Py_XDECREF(args[i]);
+        throw;
+    }
+    return invoke(fn, args, nargs, kwargs);
+}
+
+inline PyObject* call_now(PyObject* fn, arguments args, PyObject* kwargs = NULL)
+{
+    return call_now(fn, args.begin(), args.size(), kwargs);
+}
+
+// The bound method name of the axes ax, borrowed. The methods are kept
+// for the axes they were last looked up on, so repeated calls on the same
+// axes skip the attribute lookup. Only one axes is held on to at a time,
+// and none once figure(), close() or clf() ran.
+inline PyObject* axes_method(PyObject* ax, const char* name)
+{
+    axes_method_cache& cache = axes_methods();
+    if (ax != cache.axes) {
+        release_axes_methods();
+        Py_INCREF(ax);
+        cache.axes = ax;
+    }
+
+    PyObject*& method = cache.methods[name];
+    if (!method) {
+        method = PyObject_GetAttrString(ax, name);
+        if (!method) {
+            cache.methods.erase(name);
+            throw std::runtime_error(std::string("Axes have no method ") + name + "().");
+        }
+    }
+    return method;
+}
+
+// The current axes, as a new reference.
+inline PyObject* gca()
+{
+    PyObject* ax = call_now(_interpreter::get().s_python_function_gca, {});
+    if (!ax) throw std::runtime_error("Call to gca() failed.");
+    return ax;
+}
+
 } // end namespace detail
 
+/// Records the plot calls made while it is in scope instead of running
+/// them one by one, and replays them in a single trip into python when
+/// submit() is called or the scope ends:
+///
+///     {
+///         plt::Batch batch;
+///         for (auto& series : dashboard)
+///             plt::plot(series.x, series.y);
+///         plt::title("Status");
+///         batch.submit();
+///     }
+///
+/// Only calls that don't hand anything back to C++ are recorded. Anything
+/// that needs an answer from matplotlib, like figure(), xlim() without
+/// arguments, the returned line objects or the decimation and culling
+/// options which read the axes, first replays what was recorded so far.
+/// Recorded calls report success right away; submit() runs all of them and
+/// throws one std::runtime_error naming every call that failed and its
+/// position in the batch. Arrays that borrow the caller's memory are copied
+/// when recorded. Errors left over when the scope ends can't be thrown and
+/// are written to stderr instead, so call submit() to handle them. Batches
+/// opened inside another one join it.
+class Batch
+{
+public:
+    Batch() : owner_(!detail::batch_buffer())
+    {
+        detail::_interpreter::get();
+        if (owner_)
+            detail::batch_buffer() = new std::vector<detail::command>();
+    }
+
+    ~Batch()
+    {
+        if (!owner_)
+            return;
+        // a destructor can't throw, so failures are reported on stderr
+        try { submit(); }
+        catch (const std::runtime_error& e) {
+            PyErr_Clear();
+            std::cerr << "matplotlibcpp::Batch: " << e.what() << std::endl;
+        }
+        delete detail::batch_buffer();
+        detail::batch_buffer() = nullptr;
+    }
+
+    Batch(const Batch&) = delete;
+    Batch& operator=(const Batch&) = delete;
+
+    /// Replays the calls recorded so far.
+    void submit() { detail::flush_batch(); }
+
+    /// The number of calls waiting to be replayed.
+    size_t size() const
+    {
+        return detail::batch_buffer() ? detail::batch_buffer()->size() : 0;
+    }
+
+private:
+    bool owner_;
+};
+
 /// Select the backend
 ///
 /// **NOTE:** This must be called before the first plot command to have
@@ -310,20 +679,17 @@ inline bool annotate(std::string annotation, double x, double y)
     detail::_interpreter::get();
 
     PyObject * xy = PyTuple_New(2);
-    PyObject * str = PyString_FromString(annotation.c_str());
 
     PyTuple_SetItem(xy,0,PyFloat_FromDouble(x));
     PyTuple_SetItem(xy,1,PyFloat_FromDouble(y));
 
     PyObject* kwargs = PyDict_New();
     PyDict_SetItemString(kwargs, "xy", xy);
+    Py_DECREF(xy);
 
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, str);
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_annotate, args, kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_annotate,
+                                 {PyString_FromString(annotation.c_str())}, kwargs);
 
-    Py_DECREF(args);
     Py_DECREF(kwargs);
 
     if(res) Py_DECREF(res);
@@ -333,6 +699,79 @@ inline bool annotate(std::string annotation, double x, double y)
 
 namespace detail {
 
+// Work on fewer elements than this is not worth spreading over threads.
+const size_t parallel_min_chunk = 1 << 16;
+
+// The number of threads parallel_for() spreads work over at most.
+inline size_t thread_count()
+{
+#ifndef WITHOUT_THREADS
+    return std::max(1u, std::thread::hardware_concurrency());
+#else
+    return 1;
+#endif
+}
+
+// Calls f(begin, end) on consecutive chunks covering [0, n). Large inputs
+// are split over all hardware threads, where `cost` is the number of
+// elements each index stands for (e.g. the length of a row). The first
+// exception thrown by any chunk is rethrown after all of them finished.
+template<typename F>
+void parallel_for(size_t n, const F& f, size_t cost = 1)
+{
+#ifndef WITHOUT_THREADS
+    size_t nthreads = std::min<size_t>(thread_count(), n * cost / parallel_min_chunk);
+    nthreads = std::min(nthreads, n);
+    if (nthreads > 1) {
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(nthreads);
+        const size_t chunk = (n + nthreads - 1) / nthreads;
+        for (size_t t = 0; t < nthreads; ++t) {
+            const size_t begin = std::min(n, t * chunk), end = std::min(n, begin + chunk);
+            auto work = [&f, &errors, t, begin, end]() {
+                try { f(begin, end); }
+                catch (...) { errors[t] = std::current_exception(); }
+            };
+            if (t + 1 < nthreads)
+                threads.emplace_back(work);
+            else
+                work(); // the calling thread takes the last chunk
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        for (const std::exception_ptr& error : errors)
+            if (error) std::rethrow_exception(error);
+        return;
+    }
+#endif
+    f(size_t(0), n);
+}
+
+// Converts count values that lie stride bytes apart into dst. This is what
+// every type without a direct numpy equivalent goes through, so it is kept a
+// plain loop the compiler can vectorize for the common contiguous case.
+template<typename Numeric>
+void convert_to_double_serial(const Numeric* src, size_t count, std::ptrdiff_t stride, double* dst)
+{
+    if (stride == static_cast<std::ptrdiff_t>(sizeof(Numeric))) {
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = static_cast<double>(src[i]);
+    } else {
+        const char* p = reinterpret_cast<const char*>(src);
+        for (size_t i = 0; i < count; ++i, p += stride)
+            dst[i] = static_cast<double>(*reinterpret_cast<const Numeric*>(p));
+    }
+}
+
+template<typename Numeric>
+void convert_to_double(const Numeric* src, size_t count, std::ptrdiff_t stride, double* dst)
+{
+    parallel_for(count, [=](size_t begin, size_t end) {
+        const char* p = reinterpret_cast<const char*>(src) + begin * stride;
+        convert_to_double_serial(reinterpret_cast<const Numeric*>(p), end - begin, stride, dst + begin);
+    });
+}
+
 #ifndef WITHOUT_NUMPY
 // Type selector for numpy array conversion
 template <typename T> struct select_npy_type { const static NPY_TYPES type = NPY_NOTYPE; }; //Default
@@ -345,7 +784,7 @@ template <> struct select_npy_type<int32_t> { const static NPY_TYPES type = NPY_
 template <> struct select_npy_type<int64_t> { const static NPY_TYPES type = NPY_INT64; };
 template <> struct select_npy_type<uint8_t> { const static NPY_TYPES type = NPY_UINT8; };
 template <> struct select_npy_type<uint16_t> { const static NPY_TYPES type = NPY_USHORT; };
-template <> struct select_npy_type<uint32_t> { const static NPY_TYPES type = NPY_ULONG; };
+template <> struct select_npy_type<uint32_t> { const static NPY_TYPES type = NPY_UINT32; };
 template <> struct select_npy_type<uint64_t> { const static NPY_TYPES type = NPY_UINT64; };
 
 // Sanity checks; comment them out or change the numpy type below if you're compiling on
@@ -355,18 +794,44 @@ template <> struct select_npy_type<long long> { const static NPY_TYPES type = NP
 static_assert(sizeof(unsigned long long) == 8);
 template <> struct select_npy_type<unsigned long long> { const static NPY_TYPES type = NPY_UINT64; };
 
+template<typename Owner>
+void release_owner(PyObject* capsule)
+{
+    delete static_cast<Owner*>(PyCapsule_GetPointer(capsule, nullptr));
+}
+
+// Makes `varray` keep `owner` alive: the owner is handed to a capsule which
+// becomes the array's base object and is deleted once numpy (and anything in
+// matplotlib still holding on to the array) drops its last reference.
+template<typename Owner>
+PyObject* attach_owner(PyObject* varray, Owner* owner)
+{
+    PyObject* capsule = PyCapsule_New(owner, nullptr, &release_owner<Owner>);
+    if (!capsule) {
+        delete owner;
+        Py_DECREF(varray);
+        throw std::runtime_error("Couldn't create owner capsule for numpy array.");
+    }
+    // steals the reference to capsule, even on failure
+    if (PyArray_SetBaseObject(reinterpret_cast<PyArrayObject*>(varray), capsule) != 0) {
+        Py_DECREF(varray);
+        throw std::runtime_error("Couldn't set base object of numpy array.");
+    }
+    return varray;
+}
+
+// Borrows the vector's buffer, which must therefore outlive every use of the
+// returned array on the python side. Use the overloads below to hand over
+// ownership instead.
 template<typename Numeric>
 PyObject* get_array(const std::vector<Numeric>& v)
 {
     npy_intp vsize = v.size();
     NPY_TYPES type = select_npy_type<Numeric>::type;
     if (type == NPY_NOTYPE) {
-        size_t memsize = v.size()*sizeof(double);
-        double* dp = static_cast<double*>(::malloc(memsize));
-        for (size_t i=0; i<v.size(); ++i)
-            dp[i] = v[i];
-        PyObject* varray = PyArray_SimpleNewFromData(1, &vsize, NPY_DOUBLE, dp);
-        PyArray_UpdateFlags(reinterpret_cast<PyArrayObject*>(varray), NPY_ARRAY_OWNDATA);
+        PyObject* varray = PyArray_SimpleNew(1, &vsize, NPY_DOUBLE);
+        double* dp = static_cast<double*>(PyArray_DATA(reinterpret_cast<PyArrayObject*>(varray)));
+        convert_to_double(v.data(), v.size(), sizeof(Numeric), dp);
         return varray;
     }
 
@@ -374,6 +839,71 @@ PyObject* get_array(const std::vector<Numeric>& v)
     return varray;
 }
 
+// Creates a double array of count elements and lets fill write straight
+// into its buffer.
+template<typename Fill>
+PyObject* new_double_array(size_t count, const Fill& fill)
+{
+    npy_intp vsize = count;
+    PyObject* varray = PyArray_SimpleNew(1, &vsize, NPY_DOUBLE);
+    try {
+        fill(static_cast<double*>(PyArray_DATA(reinterpret_cast<PyArrayObject*>(varray))));
+    } catch (...) {
+        Py_DECREF(varray);
+        throw;
+    }
+    return varray;
+}
+
+// Wraps `count` values starting at `data` that lie `stride` bytes apart, so
+// e.g. one member of an array of structs can be plotted without gathering it
+// into a vector first. Like the overload above, this borrows the data.
+template<typename Numeric>
+PyObject* get_array(const Numeric* data, size_t count, std::ptrdiff_t stride = sizeof(Numeric))
+{
+    npy_intp vsize = count;
+    NPY_TYPES type = select_npy_type<Numeric>::type;
+    if (type == NPY_NOTYPE) {
+        return new_double_array(count, [=](double* vd) {
+            convert_to_double(data, count, stride, vd);
+        });
+    }
+
+    // a read-only, possibly strided view of the caller's memory
+    npy_intp vstride = stride;
+    PyObject* varray = PyArray_New(&PyArray_Type, 1, &vsize, type, &vstride, (void*)(data), 0, 0, NULL);
+    return varray;
+}
+
+// Takes over the vector's buffer without copying it. The data is freed when
+// the last python reference to the array goes away.
+template<typename Numeric>
+PyObject* get_array(std::vector<Numeric>&& v)
+{
+    NPY_TYPES type = select_npy_type<Numeric>::type;
+    if (type == NPY_NOTYPE)
+        return get_array(v); // converted into a buffer owned by numpy anyways
+
+    std::vector<Numeric>* owner = new std::vector<Numeric>(std::move(v));
+    npy_intp vsize = owner->size();
+    PyObject* varray = PyArray_SimpleNewFromData(1, &vsize, type, (void*)(owner->data()));
+    return attach_owner(varray, owner);
+}
+
+// Shares ownership of the vector with the returned array, so the data stays
+// valid for as long as either side still uses it.
+template<typename Numeric>
+PyObject* get_array(const std::shared_ptr<std::vector<Numeric>>& v)
+{
+    NPY_TYPES type = select_npy_type<Numeric>::type;
+    if (type == NPY_NOTYPE)
+        return get_array(*v);
+
+    npy_intp vsize = v->size();
+    PyObject* varray = PyArray_SimpleNewFromData(1, &vsize, type, (void*)(v->data()));
+    return attach_owner(varray, new std::shared_ptr<std::vector<Numeric>>(v));
+}
+
 
 template<typename Numeric>
 PyObject* get_2darray(const std::vector<::std::vector<Numeric>>& v)
@@ -383,807 +913,3336 @@ PyObject* get_2darray(const std::vector<::std::vector<Numeric>>& v)
     npy_intp vsize[2] = {static_cast<npy_intp>(v.size()),
                          static_cast<npy_intp>(v[0].size())};
 
+    // The rows have to be gathered into one block anyways, but there is no
+    // need to widen them on the way unless numpy doesn't know the type.
+    const bool convert = select_npy_type<Numeric>::type == NPY_NOTYPE;
+    typedef typename std::conditional<select_npy_type<Numeric>::type == NPY_NOTYPE,
+                                      double, Numeric>::type value_type;
+
     PyArrayObject *varray =
-        (PyArrayObject *)PyArray_SimpleNew(2, vsize, NPY_DOUBLE);
+        (PyArrayObject *)PyArray_SimpleNew(2, vsize, convert ? NPY_DOUBLE : select_npy_type<Numeric>::type);
 
-    double *vd_begin = static_cast<double *>(PyArray_DATA(varray));
+    value_type *vd_begin = static_cast<value_type *>(PyArray_DATA(varray));
 
     for (const ::std::vector<Numeric> &v_row : v) {
-      if (v_row.size() != static_cast<size_t>(vsize[1]))
+      if (v_row.size() != static_cast<size_t>(vsize[1])) {
+        Py_DECREF(varray);
         throw std::runtime_error("Missmatched array size");
-      std::copy(v_row.begin(), v_row.end(), vd_begin);
-      vd_begin += vsize[1];
+      }
     }
 
+    const size_t cols = vsize[1];
+    parallel_for(v.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i)
+        std::copy(v[i].begin(), v[i].end(), vd_begin + i * cols);
+    }, cols);
+
     return reinterpret_cast<PyObject *>(varray);
 }
 
-#else // fallback if we don't have numpy: copy every element of the given vector
-
+// Wraps a row-major rows x cols grid without copying it. Rows start
+// row_pitch bytes apart, where 0 means they are packed back to back.
 template<typename Numeric>
-PyObject* get_array(const std::vector<Numeric>& v)
+PyObject* get_2darray(const Numeric* data, size_t rows, size_t cols, std::ptrdiff_t row_pitch = 0)
 {
-    PyObject* list = PyList_New(v.size());
-    for(size_t i = 0; i < v.size(); ++i) {
-        PyList_SetItem(list, i, PyFloat_FromDouble(v.at(i)));
+    if (row_pitch == 0)
+        row_pitch = cols * sizeof(Numeric);
+
+    npy_intp vsize[2] = {static_cast<npy_intp>(rows), static_cast<npy_intp>(cols)};
+
+    NPY_TYPES type = select_npy_type<Numeric>::type;
+    if (type == NPY_NOTYPE) {
+        PyArrayObject *varray =
+            (PyArrayObject *)PyArray_SimpleNew(2, vsize, NPY_DOUBLE);
+
+        double *vd = static_cast<double *>(PyArray_DATA(varray));
+        parallel_for(rows, [=](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            const char* row = reinterpret_cast<const char*>(data) + i * row_pitch;
+            convert_to_double_serial(reinterpret_cast<const Numeric*>(row), cols, sizeof(Numeric), vd + i * cols);
+          }
+        }, cols);
+        return reinterpret_cast<PyObject *>(varray);
     }
-    return list;
+
+    npy_intp vstrides[2] = {static_cast<npy_intp>(row_pitch), static_cast<npy_intp>(sizeof(Numeric))};
+    PyObject* varray = PyArray_New(&PyArray_Type, 2, vsize, type, vstrides, (void*)(data), 0, 0, NULL);
+    return varray;
 }
 
-#endif // WITHOUT_NUMPY
+// Takes over a row-major rows x cols grid that was computed in C++.
+inline PyObject* get_2darray(std::vector<double>&& v, size_t rows, size_t cols)
+{
+    std::vector<double>* owner = new std::vector<double>(std::move(v));
+    npy_intp vsize[2] = {static_cast<npy_intp>(rows), static_cast<npy_intp>(cols)};
+    PyObject* varray = PyArray_SimpleNewFromData(2, vsize, NPY_DOUBLE, (void*)(owner->data()));
+    return attach_owner(varray, owner);
+}
 
-// sometimes, for labels and such, we need string arrays
-inline PyObject * get_array(const std::vector<std::string>& strings)
+#else // fallback if we don't have numpy: copy the values into array.array('d') buffers
+
+// Creates an array.array('d') of count elements and lets fill write
+// straight into its buffer.
+template<typename Fill>
+PyObject* new_double_array(size_t count, const Fill& fill)
 {
-  PyObject* list = PyList_New(strings.size());
-  for (std::size_t i = 0; i < strings.size(); ++i) {
-    PyList_SetItem(list, i, PyString_FromString(strings[i].c_str()));
-  }
-  return list;
+    PyObject* args = Py_BuildValue("(s[d])", "d", 0.0);
+    PyObject* item = PyObject_CallObject(_interpreter::get().s_python_array_type, args);
+    Py_DECREF(args);
+    if (!item) throw std::runtime_error("Couldn't create array.array");
+
+    PyObject* varray = PySequence_Repeat(item, static_cast<Py_ssize_t>(count));
+    Py_DECREF(item);
+    if (!varray) throw std::runtime_error("Couldn't create array.array");
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(varray, &view, PyBUF_WRITABLE) != 0) {
+        Py_DECREF(varray);
+        throw std::runtime_error("Couldn't get the buffer of array.array");
+    }
+    try {
+        fill(static_cast<double*>(view.buf));
+    } catch (...) {
+        PyBuffer_Release(&view);
+        Py_DECREF(varray);
+        throw;
+    }
+    PyBuffer_Release(&view);
+    return varray;
 }
 
-// not all matplotlib need 2d arrays, some prefer lists of lists
-template<typename Numeric>
-PyObject* get_listlist(const std::vector<std::vector<Numeric>>& ll)
+// matplotlib's 3d and image functions insist on real ndarrays, so the flat
+// buffer gets reshaped by numpy.frombuffer, which shares it instead of copying.
+inline PyObject* reshape_2darray(PyObject* flat, size_t rows, size_t cols)
 {
-  PyObject* listlist = PyList_New(ll.size());
-  for (std::size_t i = 0; i < ll.size(); ++i) {
-    PyList_SetItem(listlist, i, get_array(ll[i]));
-  }
-  return listlist;
+    PyObject* varray = PyObject_CallFunctionObjArgs(_interpreter::get().s_python_function_frombuffer, flat, NULL);
+    Py_DECREF(flat);
+    if (!varray) throw std::runtime_error("Call to numpy.frombuffer() failed.");
+
+    PyObject* res = PyObject_CallMethod(varray, const_cast<char*>("reshape"), const_cast<char*>("(nn)"),
+                                        static_cast<Py_ssize_t>(rows), static_cast<Py_ssize_t>(cols));
+    Py_DECREF(varray);
+    if (!res) throw std::runtime_error("Call to reshape() failed.");
+    return res;
 }
 
-} // namespace detail
+template<typename Numeric>
+PyObject* get_array(const Numeric* data, size_t count, std::ptrdiff_t stride = sizeof(Numeric))
+{
+    return new_double_array(count, [=](double* vd) {
+        convert_to_double(data, count, stride, vd);
+    });
+}
 
-/// Plot a line through the given x and y data points..
-///
-/// See: https://matplotlib.org/3.2.1/api/_as_gen/matplotlib.pyplot.plot.html
 template<typename Numeric>
-bool plot(const std::vector<Numeric> &x, const std::vector<Numeric> &y, const std::map<std::string, std::string>& keywords)
+PyObject* get_array(const std::vector<Numeric>& v)
 {
-    assert(x.size() == y.size());
+    return get_array(v.data(), v.size());
+}
 
-    detail::_interpreter::get();
+// the array.array holds copies of the values, so there is no buffer to take over
+template<typename Numeric>
+PyObject* get_array(std::vector<Numeric>&& v)
+{
+    return get_array(v);
+}
 
-    // using numpy arrays
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
+template<typename Numeric>
+PyObject* get_array(const std::shared_ptr<std::vector<Numeric>>& v)
+{
+    return get_array(*v);
+}
 
-    // construct positional args
-    PyObject* args = PyTuple_New(2);
-    PyTuple_SetItem(args, 0, xarray);
-    PyTuple_SetItem(args, 1, yarray);
+template<typename Numeric>
+PyObject* get_2darray(const std::vector<::std::vector<Numeric>>& v)
+{
+    if (v.size() < 1) throw std::runtime_error("get_2d_array v too small");
 
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-    {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyString_FromString(it->second.c_str()));
+    const size_t cols = v[0].size();
+    for (const ::std::vector<Numeric> &v_row : v) {
+      if (v_row.size() != cols)
+        throw std::runtime_error("Missmatched array size");
     }
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_plot, args, kwargs);
+    PyObject* flat = new_double_array(v.size() * cols, [&](double* vd) {
+      parallel_for(v.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+          std::copy(v[i].begin(), v[i].end(), vd + i * cols);
+      }, cols);
+    });
+    return reshape_2darray(flat, v.size(), cols);
+}
 
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
-    if(res) Py_DECREF(res);
-
-    return res;
+template<typename Numeric>
+PyObject* get_2darray(const Numeric* data, size_t rows, size_t cols, std::ptrdiff_t row_pitch = 0)
+{
+    if (row_pitch == 0)
+        row_pitch = cols * sizeof(Numeric);
+
+    PyObject* flat = new_double_array(rows * cols, [=](double* vd) {
+      parallel_for(rows, [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const char* row = reinterpret_cast<const char*>(data) + i * row_pitch;
+          convert_to_double_serial(reinterpret_cast<const Numeric*>(row), cols, sizeof(Numeric), vd + i * cols);
+        }
+      }, cols);
+    });
+    return reshape_2darray(flat, rows, cols);
 }
 
-// TODO - it should be possible to make this work by implementing
-// a non-numpy alternative for `detail::get_2darray()`.
-#ifndef WITHOUT_NUMPY
-template <typename Numeric>
-void plot_surface(const std::vector<::std::vector<Numeric>> &x,
-                  const std::vector<::std::vector<Numeric>> &y,
-                  const std::vector<::std::vector<Numeric>> &z,
-                  const std::map<std::string, std::string> &keywords =
-                      std::map<std::string, std::string>(),
-                  const long fig_number=0)
+inline PyObject* get_2darray(std::vector<double>&& v, size_t rows, size_t cols)
 {
-  detail::_interpreter::get();
-
-  // We lazily load the modules here the first time this function is called
-  // because I'm not sure that we can assume "matplotlib installed" implies
-  // "mpl_toolkits installed" on all platforms, and we don't want to require
-  // it for people who don't need 3d plots.
-  static PyObject *mpl_toolkitsmod = nullptr, *axis3dmod = nullptr;
-  if (!mpl_toolkitsmod) {
-    detail::_interpreter::get();
-
-    PyObject* mpl_toolkits = PyString_FromString("mpl_toolkits");
-    PyObject* axis3d = PyString_FromString("mpl_toolkits.mplot3d");
-    if (!mpl_toolkits || !axis3d) { throw std::runtime_error("couldnt create string"); }
-
-    mpl_toolkitsmod = PyImport_Import(mpl_toolkits);
-    Py_DECREF(mpl_toolkits);
-    if (!mpl_toolkitsmod) { throw std::runtime_error("Error loading module mpl_toolkits!"); }
-
-    axis3dmod = PyImport_Import(axis3d);
-    Py_DECREF(axis3d);
-    if (!axis3dmod) { throw std::runtime_error("Error loading module mpl_toolkits.mplot3d!"); }
-  }
+    return reshape_2darray(get_array(v), rows, cols);
+}
 
-  assert(x.size() == y.size());
-  assert(y.size() == z.size());
+#endif // WITHOUT_NUMPY
 
-  // using numpy arrays
-  PyObject *xarray = detail::get_2darray(x);
-  PyObject *yarray = detail::get_2darray(y);
-  PyObject *zarray = detail::get_2darray(z);
+// Copies `count` values read through any input iterator into a new double
+// array, for containers that don't keep their elements in one block.
+template<typename Iterator>
+PyObject* copy_to_array(Iterator first, size_t count)
+{
+    return new_double_array(count, [&](double* vd) {
+        std::copy_n(first, count, vd);
+    });
+}
 
-  // construct positional args
-  PyObject *args = PyTuple_New(3);
-  PyTuple_SetItem(args, 0, xarray);
-  PyTuple_SetItem(args, 1, yarray);
-  PyTuple_SetItem(args, 2, zarray);
+// Evaluates f at the count ticks starting at first and stores the results
+// in y. With `parallel` set, random access ticks are split over all hardware
+// threads, one tick per work item since f is assumed to be expensive.
+template<typename Iterator, typename Callable>
+void evaluate(Iterator first, size_t count, const Callable& f, double* y, bool /*parallel*/, std::input_iterator_tag)
+{
+    for (size_t i = 0; i < count; ++i, ++first)
+        y[i] = f(*first);
+}
 
-  // Build up the kw args.
-  PyObject *kwargs = PyDict_New();
-  PyDict_SetItemString(kwargs, "rstride", PyInt_FromLong(1));
-  PyDict_SetItemString(kwargs, "cstride", PyInt_FromLong(1));
+template<typename Iterator, typename Callable>
+void evaluate(Iterator first, size_t count, const Callable& f, double* y, bool parallel, std::random_access_iterator_tag)
+{
+    if (!parallel)
+        return evaluate(first, count, f, y, false, std::input_iterator_tag());
 
-  PyObject *python_colormap_coolwarm = PyObject_GetAttrString(
-      detail::_interpreter::get().s_python_colormap, "coolwarm");
+    parallel_for(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            y[i] = f(first[i]);
+    }, parallel_min_chunk);
+}
 
-  PyDict_SetItemString(kwargs, "cmap", python_colormap_coolwarm);
+template<typename Iterator, typename Callable>
+void evaluate(Iterator first, size_t count, const Callable& f, double* y, bool parallel)
+{
+    evaluate(first, count, f, y, parallel, typename std::iterator_traits<Iterator>::iterator_category());
+}
 
-  for (std::map<std::string, std::string>::const_iterator it = keywords.begin();
-       it != keywords.end(); ++it) {
-    if (it->first == "linewidth" || it->first == "alpha") {
-      PyDict_SetItemString(kwargs, it->first.c_str(),
-        PyFloat_FromDouble(std::stod(it->second)));
-    } else {
-      PyDict_SetItemString(kwargs, it->first.c_str(),
-        PyString_FromString(it->second.c_str()));
-    }
+// sometimes, for labels and such, we need string arrays
+inline PyObject * get_array(const std::vector<std::string>& strings)
+{
+  PyObject* list = PyList_New(strings.size());
+  for (std::size_t i = 0; i < strings.size(); ++i) {
+    PyList_SetItem(list, i, PyString_FromString(strings[i].c_str()));
   }
+  return list;
+}
 
-  PyObject *fig_args = PyTuple_New(1);
-  PyObject* fig = nullptr;
-  PyTuple_SetItem(fig_args, 0, PyLong_FromLong(fig_number));
-  PyObject *fig_exists =
-    PyObject_CallObject(
-    detail::_interpreter::get().s_python_function_fignum_exists, fig_args);
-  if (!PyObject_IsTrue(fig_exists)) {
-    fig = PyObject_CallObject(detail::_interpreter::get().s_python_function_figure,
-      detail::_interpreter::get().s_python_empty_tuple);
-  } else {
-    fig = PyObject_CallObject(detail::_interpreter::get().s_python_function_figure,
-      fig_args);
+// not all matplotlib need 2d arrays, some prefer lists of lists
+template<typename Numeric>
+PyObject* get_listlist(const std::vector<std::vector<Numeric>>& ll)
+{
+  PyObject* listlist = PyList_New(ll.size());
+  for (std::size_t i = 0; i < ll.size(); ++i) {
+    PyList_SetItem(listlist, i, get_array(ll[i]));
   }
-  Py_DECREF(fig_exists);
-  if (!fig) throw std::runtime_error("Call to figure() failed.");
-
-  PyObject *gca_kwargs = PyDict_New();
-  PyDict_SetItemString(gca_kwargs, "projection", PyString_FromString("3d"));
-
-  PyObject *gca = PyObject_GetAttrString(fig, "gca");
-  if (!gca) throw std::runtime_error("No gca");
-  Py_INCREF(gca);
-  PyObject *axis = PyObject_Call(
-      gca, detail::_interpreter::get().s_python_empty_tuple, gca_kwargs);
-
-  if (!axis) throw std::runtime_error("No axis");
-  Py_INCREF(axis);
-
-  Py_DECREF(gca);
-  Py_DECREF(gca_kwargs);
-
-  PyObject *plot_surface = PyObject_GetAttrString(axis, "plot_surface");
-  if (!plot_surface) throw std::runtime_error("No surface");
-  Py_INCREF(plot_surface);
-  PyObject *res = PyObject_Call(plot_surface, args, kwargs);
-  if (!res) throw std::runtime_error("failed surface");
-  Py_DECREF(plot_surface);
-
-  Py_DECREF(axis);
-  Py_DECREF(args);
-  Py_DECREF(kwargs);
-  if (res) Py_DECREF(res);
+  return listlist;
 }
 
-template <typename Numeric>
-void contour(const std::vector<::std::vector<Numeric>> &x,
-             const std::vector<::std::vector<Numeric>> &y,
-             const std::vector<::std::vector<Numeric>> &z,
-             const std::map<std::string, std::string> &keywords = {})
+} // namespace detail
+
+/// A keyword argument's value: a number, a bool, a string or an array of
+/// numbers, which reaches matplotlib as the matching python type.
+class KeywordValue
 {
-  detail::_interpreter::get();
+public:
+    enum Kind { String, Double, Long, Bool, Array };
 
-  // using numpy arrays
-  PyObject *xarray = detail::get_2darray(x);
-  PyObject *yarray = detail::get_2darray(y);
-  PyObject *zarray = detail::get_2darray(z);
+    KeywordValue(const char* value) : kind_(String), string_(value), number_(0), long_(0) {}
+    KeywordValue(const std::string& value) : kind_(String), string_(value), number_(0), long_(0) {}
 
-  // construct positional args
-  PyObject *args = PyTuple_New(3);
-  PyTuple_SetItem(args, 0, xarray);
-  PyTuple_SetItem(args, 1, yarray);
-  PyTuple_SetItem(args, 2, zarray);
+    template<typename Numeric, typename = typename std::enable_if<std::is_arithmetic<Numeric>::value>::type>
+    KeywordValue(Numeric value)
+        : kind_(std::is_same<Numeric, bool>::value ? Bool
+                : std::is_integral<Numeric>::value ? Long : Double),
+          number_(static_cast<double>(value)), long_(static_cast<long>(value)) {}
 
-  // Build up the kw args.
-  PyObject *kwargs = PyDict_New();
+    /// Arrays, e.g. per point colors, go through the same conversion as data.
+    template<typename Numeric, typename = typename std::enable_if<std::is_arithmetic<Numeric>::value>::type>
+    KeywordValue(const std::vector<Numeric>& values)
+        : kind_(Array), number_(0), long_(0),
+          array_(std::make_shared<std::vector<double>>(values.begin(), values.end())) {}
 
-  PyObject *python_colormap_coolwarm = PyObject_GetAttrString(
-      detail::_interpreter::get().s_python_colormap, "coolwarm");
+    Kind kind() const { return kind_; }
+    bool is_string() const { return kind_ == String; }
 
-  PyDict_SetItemString(kwargs, "cmap", python_colormap_coolwarm);
+    /// The string, or an empty one for other kinds.
+    const std::string& str() const { return string_; }
 
-  for (std::map<std::string, std::string>::const_iterator it = keywords.begin();
-       it != keywords.end(); ++it) {
-    PyDict_SetItemString(kwargs, it->first.c_str(),
-                         PyString_FromString(it->second.c_str()));
-  }
+    /// The number, parsing strings like "0.5".
+    double to_double() const
+    {
+        if (kind_ == String) return std::stod(string_);
+        return number_;
+    }
 
-  PyObject *res = PyObject_Call(detail::_interpreter::get().s_python_function_contour, args, kwargs);
-  if (!res)
-    throw std::runtime_error("failed contour");
+    /// A new reference to the python value.
+    PyObject* to_python() const
+    {
+        switch (kind_) {
+        case Double: return PyFloat_FromDouble(number_);
+        case Long:   return PyLong_FromLong(long_);
+        case Bool:   return PyBool_FromLong(long_);
+        case Array:  return detail::get_array(array_);
+        default:     return PyString_FromString(string_.c_str());
+        }
+    }
 
-  Py_DECREF(args);
-  Py_DECREF(kwargs);
-  if (res) Py_DECREF(res);
-}
+private:
+    Kind kind_;
+    std::string string_;
+    double number_;
+    long long_;
+    std::shared_ptr<std::vector<double>> array_;
+};
 
-template <typename Numeric>
-void spy(const std::vector<::std::vector<Numeric>> &x,
-         const double markersize = -1,  // -1 for default matplotlib size
-         const std::map<std::string, std::string> &keywords = {})
+/// Keyword arguments for matplotlib, e.g. {{"color", "r"}, {"linewidth", 2}}.
+/// They are turned into a python dictionary once, on first use, which is
+/// kept with them. So a Keywords object that is passed again and again,
+/// e.g. in an update loop, is handed over without converting any of its
+/// keys and values anew. Copies share the dictionary.
+class Keywords
 {
-  detail::_interpreter::get();
+public:
+    typedef std::map<std::string, KeywordValue> map_type;
+    typedef map_type::const_iterator const_iterator;
 
-  PyObject *xarray = detail::get_2darray(x);
+    Keywords() : dict_(nullptr) {}
+    Keywords(std::initializer_list<map_type::value_type> items) : items_(items), dict_(nullptr) {}
 
-  PyObject *kwargs = PyDict_New();
-  if (markersize != -1) {
-    PyDict_SetItemString(kwargs, "markersize", PyFloat_FromDouble(markersize));
-  }
-  for (std::map<std::string, std::string>::const_iterator it = keywords.begin();
-       it != keywords.end(); ++it) {
-    PyDict_SetItemString(kwargs, it->first.c_str(),
-                         PyString_FromString(it->second.c_str()));
-  }
+    /// From maps of strings or numbers, as the functions took before.
+    template<typename Value>
+    Keywords(const std::map<std::string, Value>& items) : items_(items.begin(), items.end()), dict_(nullptr) {}
 
-  PyObject *plot_args = PyTuple_New(1);
-  PyTuple_SetItem(plot_args, 0, xarray);
+    Keywords(const Keywords& other) : items_(other.items_), dict_(other.dict_)
+    {
+        Py_XINCREF(dict_);
+    }
 
-  PyObject *res = PyObject_Call(
-      detail::_interpreter::get().s_python_function_spy, plot_args, kwargs);
+    Keywords& operator=(Keywords other)
+    {
+        items_.swap(other.items_);
+        std::swap(dict_, other.dict_);
+        return *this;
+    }
 
-  Py_DECREF(plot_args);
-  Py_DECREF(kwargs);
-  if (res) Py_DECREF(res);
-}
-#endif // WITHOUT_NUMPY
+    ~Keywords()
+    {
+        // a Keywords object may outlive the interpreter
+        if (dict_ && Py_IsInitialized()) Py_DECREF(dict_);
+    }
 
-template <typename Numeric>
-void plot3(const std::vector<Numeric> &x,
-                  const std::vector<Numeric> &y,
-                  const std::vector<Numeric> &z,
-                  const std::map<std::string, std::string> &keywords =
-                      std::map<std::string, std::string>(),
-                  const long fig_number=0)
-{
-  detail::_interpreter::get();
+    const_iterator begin() const { return items_.begin(); }
+    const_iterator end() const { return items_.end(); }
+    const_iterator find(const std::string& key) const { return items_.find(key); }
+    size_t count(const std::string& key) const { return items_.count(key); }
+    size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
 
-  // Same as with plot_surface: We lazily load the modules here the first time
-  // this function is called because I'm not sure that we can assume "matplotlib
-  // installed" implies "mpl_toolkits installed" on all platforms, and we don't
-  // want to require it for people who don't need 3d plots.
-  static PyObject *mpl_toolkitsmod = nullptr, *axis3dmod = nullptr;
-  if (!mpl_toolkitsmod) {
-    detail::_interpreter::get();
+    /// The keywords as a python dictionary (a borrowed reference).
+    PyObject* dict() const
+    {
+        if (!dict_) {
+            detail::_interpreter::get();
+
+            PyObject* dict = PyDict_New();
+            for (const_iterator it = items_.begin(); it != items_.end(); ++it) {
+                PyObject* key = PyString_InternFromString(it->first.c_str());
+                PyObject* value = it->second.to_python();
+                PyDict_SetItem(dict, key, value);
+                Py_DECREF(key);
+                Py_DECREF(value);
+            }
+            dict_ = dict;
+        }
+        return dict_;
+    }
 
-    PyObject* mpl_toolkits = PyString_FromString("mpl_toolkits");
-    PyObject* axis3d = PyString_FromString("mpl_toolkits.mplot3d");
-    if (!mpl_toolkits || !axis3d) { throw std::runtime_error("couldnt create string"); }
+    /// Adds the keywords to kwargs, replacing any that are there already.
+    void add_to(PyObject* kwargs) const
+    {
+        if (!items_.empty())
+            PyDict_Update(kwargs, dict());
+    }
 
-    mpl_toolkitsmod = PyImport_Import(mpl_toolkits);
-    Py_DECREF(mpl_toolkits);
-    if (!mpl_toolkitsmod) { throw std::runtime_error("Error loading module mpl_toolkits!"); }
+private:
+    map_type items_;
+    mutable PyObject* dict_;
+};
 
-    axis3dmod = PyImport_Import(axis3d);
-    Py_DECREF(axis3d);
-    if (!axis3dmod) { throw std::runtime_error("Error loading module mpl_toolkits.mplot3d!"); }
-  }
+namespace detail {
 
-  assert(x.size() == y.size());
-  assert(y.size() == z.size());
+// The functions below do the actual work for the plotting functions that
+// exist in several flavours (vectors, raw pointers, ...). All of them steal
+// the references to the arrays they are given.
 
-  PyObject *xarray = detail::get_array(x);
-  PyObject *yarray = detail::get_array(y);
-  PyObject *zarray = detail::get_array(z);
+// Set while building the arrays of a line to be told about the lines the
+// next call of plot() below creates, e.g. to follow them when zooming.
+inline std::function<void(PyObject* lines)>& plot_hook()
+{
+    static std::function<void(PyObject*)> hook;
+    return hook;
+}
 
-  // construct positional args
-  PyObject *args = PyTuple_New(3);
-  PyTuple_SetItem(args, 0, xarray);
-  PyTuple_SetItem(args, 1, yarray);
-  PyTuple_SetItem(args, 2, zarray);
+// Calls fn(x, y, format, **kwargs) for fn in plot, semilogx, stem, fill, ...
+// xarray may be NULL to let matplotlib number the points, an empty format
+// is left out and kwargs may be NULL.
+inline bool plot(PyObject* fn, PyObject* xarray, PyObject* yarray, const std::string& format, PyObject* kwargs)
+{
+    std::function<void(PyObject*)> hook;
+    hook.swap(plot_hook());
+
+    PyObject* plot_args[3];
+    size_t nargs = 0;
+    if (xarray)
+        plot_args[nargs++] = xarray;
+    plot_args[nargs++] = yarray;
+    if (!format.empty())
+        plot_args[nargs++] = PyString_FromString(format.c_str());
+
+    PyObject* res = hook ? call_now(fn, plot_args, nargs, kwargs) : call(fn, plot_args, nargs, kwargs);
+
+    if (res && hook) {
+        try { hook(res); }
+        catch (...) { Py_DECREF(res); throw; }
+    }
+    if(res) Py_DECREF(res);
 
-  // Build up the kw args.
-  PyObject *kwargs = PyDict_New();
+    return res;
+}
 
-  for (std::map<std::string, std::string>::const_iterator it = keywords.begin();
-       it != keywords.end(); ++it) {
-    PyDict_SetItemString(kwargs, it->first.c_str(),
-                         PyString_FromString(it->second.c_str()));
-  }
+inline bool plot(PyObject* fn, PyObject* xarray, PyObject* yarray, const Keywords& keywords)
+{
+    // the dictionary is passed as is, python doesn't change it
+    return plot(fn, xarray, yarray, "", keywords.empty() ? NULL : keywords.dict());
+}
 
-  PyObject *fig_args = PyTuple_New(1);
-  PyObject* fig = nullptr;
-  PyTuple_SetItem(fig_args, 0, PyLong_FromLong(fig_number));
-  PyObject *fig_exists =
-    PyObject_CallObject(detail::_interpreter::get().s_python_function_fignum_exists, fig_args);
-  if (!PyObject_IsTrue(fig_exists)) {
-    fig = PyObject_CallObject(detail::_interpreter::get().s_python_function_figure,
-      detail::_interpreter::get().s_python_empty_tuple);
-  } else {
-    fig = PyObject_CallObject(detail::_interpreter::get().s_python_function_figure,
-      fig_args);
-  }
-  if (!fig) throw std::runtime_error("Call to figure() failed.");
+inline bool named_plot(PyObject* fn, const std::string& name, PyObject* xarray, PyObject* yarray, const std::string& format)
+{
+    PyObject* kwargs = PyDict_New();
+    PyDict_SetItemString(kwargs, "label", PyString_FromString(name.c_str()));
 
-  PyObject *gca_kwargs = PyDict_New();
-  PyDict_SetItemString(gca_kwargs, "projection", PyString_FromString("3d"));
+    bool res = plot(fn, xarray, yarray, format, kwargs);
 
-  PyObject *gca = PyObject_GetAttrString(fig, "gca");
-  if (!gca) throw std::runtime_error("No gca");
-  Py_INCREF(gca);
-  PyObject *axis = PyObject_Call(
-      gca, detail::_interpreter::get().s_python_empty_tuple, gca_kwargs);
+    Py_DECREF(kwargs);
 
-  if (!axis) throw std::runtime_error("No axis");
-  Py_INCREF(axis);
+    return res;
+}
 
-  Py_DECREF(gca);
-  Py_DECREF(gca_kwargs);
+inline bool fill_between(PyObject* xarray, PyObject* y1array, PyObject* y2array, const Keywords& keywords)
+{
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_fill_between,
+                                 {xarray, y1array, y2array}, keywords.empty() ? NULL : keywords.dict());
 
-  PyObject *plot3 = PyObject_GetAttrString(axis, "plot");
-  if (!plot3) throw std::runtime_error("No 3D line plot");
-  Py_INCREF(plot3);
-  PyObject *res = PyObject_Call(plot3, args, kwargs);
-  if (!res) throw std::runtime_error("Failed 3D line plot");
-  Py_DECREF(plot3);
+    if(res) Py_DECREF(res);
 
-  Py_DECREF(axis);
-  Py_DECREF(args);
-  Py_DECREF(kwargs);
-  if (res) Py_DECREF(res);
+    return res;
 }
 
-template<typename Numeric>
-bool stem(const std::vector<Numeric> &x, const std::vector<Numeric> &y, const std::map<std::string, std::string>& keywords)
+// colors_array may be NULL
+inline bool scatter(PyObject* xarray, PyObject* yarray, PyObject* colors_array, const double s, const Keywords& keywords)
 {
-    assert(x.size() == y.size());
+    PyObject* kwargs = PyDict_New();
+    PyDict_SetItemString(kwargs, "s", PyLong_FromLong(s));
+    if (colors_array) {
+        PyDict_SetItemString(kwargs, "c", colors_array);
+        Py_DECREF(colors_array);
+    }
+    keywords.add_to(kwargs);
 
-    detail::_interpreter::get();
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_scatter,
+                                 {xarray, yarray}, kwargs);
 
-    // using numpy arrays
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
+    Py_DECREF(kwargs);
+    if(res) Py_DECREF(res);
 
-    // construct positional args
-    PyObject* args = PyTuple_New(2);
-    PyTuple_SetItem(args, 0, xarray);
-    PyTuple_SetItem(args, 1, yarray);
+    return res;
+}
 
+inline bool errorbar(PyObject* xarray, PyObject* yarray, PyObject* yerrarray, const Keywords& keywords)
+{
     // construct keyword args
     PyObject* kwargs = PyDict_New();
-    for (std::map<std::string, std::string>::const_iterator it =
-            keywords.begin(); it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(),
-                PyString_FromString(it->second.c_str()));
-    }
+    keywords.add_to(kwargs);
+
+    PyDict_SetItemString(kwargs, "yerr", yerrarray);
+    Py_DECREF(yerrarray);
 
-    PyObject* res = PyObject_Call(
-            detail::_interpreter::get().s_python_function_stem, args, kwargs);
+    PyObject *res = detail::call(detail::_interpreter::get().s_python_function_errorbar,
+                                 {xarray, yarray}, kwargs);
 
-    Py_DECREF(args);
     Py_DECREF(kwargs);
+
     if (res)
         Py_DECREF(res);
+    else
+        throw std::runtime_error("Call to errorbar() failed.");
 
     return res;
 }
 
-template< typename Numeric >
-bool fill(const std::vector<Numeric>& x, const std::vector<Numeric>& y, const std::map<std::string, std::string>& keywords)
-{
-    assert(x.size() == y.size());
+} // namespace detail
 
-    detail::_interpreter::get();
+/// How plot() and named_plot() thin out long series, see set_decimation().
+enum class Decimation { None, MinMax, M4, LTTB };
 
-    // using numpy arrays
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
+/// How plot() and fill() drop vertices of long paths, see set_simplification().
+enum class Simplification { None, RDP, Visvalingam };
 
-    // construct positional args
-    PyObject* args = PyTuple_New(2);
-    PyTuple_SetItem(args, 0, xarray);
-    PyTuple_SetItem(args, 1, yarray);
+namespace detail {
 
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for (auto it = keywords.begin(); it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-    }
+inline Decimation& decimation_mode()
+{
+    static Decimation mode = Decimation::None;
+    return mode;
+}
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_fill, args, kwargs);
+inline bool& viewport_culling()
+{
+    static bool enabled = false;
+    return enabled;
+}
 
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
+inline bool& interactive_decimation()
+{
+    static bool enabled = false;
+    return enabled;
+}
 
-    if (res) Py_DECREF(res);
+inline Simplification& simplification_mode()
+{
+    static Simplification mode = Simplification::None;
+    return mode;
+}
 
-    return res;
+// in pixels
+inline double& simplification_tolerance()
+{
+    static double tolerance = 0.25;
+    return tolerance;
 }
 
-template< typename Numeric >
-bool fill_between(const std::vector<Numeric>& x, const std::vector<Numeric>& y1, const std::vector<Numeric>& y2, const std::map<std::string, std::string>& keywords)
+// Size of the current axes on the canvas, in pixels.
+inline void axes_pixel_size(double& width, double& height)
 {
-    assert(x.size() == y1.size());
-    assert(x.size() == y2.size());
+    PyObject* ax = gca();
+    PyObject* bbox = PyObject_GetAttrString(ax, "bbox");
+    Py_DECREF(ax);
+    if (!bbox) throw std::runtime_error("Couldn't get the bbox of the axes.");
+
+    PyObject* w = PyObject_GetAttrString(bbox, "width");
+    PyObject* h = PyObject_GetAttrString(bbox, "height");
+    Py_DECREF(bbox);
+    if (!w || !h) {
+        Py_XDECREF(w);
+        Py_XDECREF(h);
+        throw std::runtime_error("Couldn't get the size of the axes.");
+    }
 
-    detail::_interpreter::get();
+    width = PyFloat_AsDouble(w);
+    height = PyFloat_AsDouble(h);
+    Py_DECREF(w);
+    Py_DECREF(h);
+}
 
-    // using numpy arrays
-    PyObject* xarray = detail::get_array(x);
-    PyObject* y1array = detail::get_array(y1);
-    PyObject* y2array = detail::get_array(y2);
+// The x (or y) limits of the current axes, if they were set explicitly,
+// e.g. by xlim(left, right). Returns false while matplotlib still autoscales
+// that axis.
+inline bool fixed_lim(char axis, double& left, double& right)
+{
+    PyObject* ax = gca();
+    const std::string autoscale_on = std::string("get_autoscale") + axis + "_on";
+    const std::string get_lim = std::string("get_") + axis + "lim";
+    PyObject* autoscale = call_now(axes_method(ax, autoscale_on.c_str()), {});
+    PyObject* lim = autoscale && !PyObject_IsTrue(autoscale)
+                  ? call_now(axes_method(ax, get_lim.c_str()), {}) : NULL;
+    Py_DECREF(ax);
+    if (!autoscale) throw std::runtime_error("Call to " + autoscale_on + "() failed.");
+    Py_DECREF(autoscale);
+    if (!lim) {
+        PyErr_Clear();
+        return false;
+    }
 
-    // construct positional args
-    PyObject* args = PyTuple_New(3);
-    PyTuple_SetItem(args, 0, xarray);
-    PyTuple_SetItem(args, 1, y1array);
-    PyTuple_SetItem(args, 2, y2array);
+    left = PyFloat_AsDouble(PyTuple_GetItem(lim, 0));
+    right = PyFloat_AsDouble(PyTuple_GetItem(lim, 1));
+    Py_DECREF(lim);
+    if (left > right) std::swap(left, right); // inverted axis
+    return true;
+}
 
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
+// The x range the current axes show once a line from x0 to x1 is added:
+// the fixed limits if there are any, otherwise the data limits including
+// that line, widened by the axes' margins as autoscaling does.
+inline void shown_x_range(double x0, double x1, double& left, double& right)
+{
+    if (fixed_lim('x', left, right)) return;
+
+    left = x0;
+    right = x1;
+    PyObject* ax = gca();
+    PyObject* has_data = call_now(axes_method(ax, "has_data"), {});
+    if (has_data && PyObject_IsTrue(has_data)) {
+        PyObject* lim = PyObject_GetAttrString(ax, "dataLim");
+        PyObject* interval = lim ? PyObject_GetAttrString(lim, "intervalx") : NULL;
+        PyObject* lo = interval ? PySequence_GetItem(interval, 0) : NULL;
+        PyObject* hi = interval ? PySequence_GetItem(interval, 1) : NULL;
+        if (lo && hi) {
+            left = std::min(left, PyFloat_AsDouble(lo));
+            right = std::max(right, PyFloat_AsDouble(hi));
+        }
+        Py_XDECREF(lo);
+        Py_XDECREF(hi);
+        Py_XDECREF(interval);
+        Py_XDECREF(lim);
     }
+    Py_XDECREF(has_data);
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_fill_between, args, kwargs);
-
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
-    if(res) Py_DECREF(res);
+    PyObject* margins = call_now(axes_method(ax, "margins"), {});
+    Py_DECREF(ax);
+    const double margin = margins ? PyFloat_AsDouble(PyTuple_GetItem(margins, 0)) : 0;
+    Py_XDECREF(margins);
+    PyErr_Clear(); // without margins or data limits the line's range will do
 
-    return res;
+    const double pad = margin * (right - left);
+    left -= pad;
+    right += pad;
 }
 
-template <typename Numeric>
-bool arrow(Numeric x, Numeric y, Numeric end_x, Numeric end_y, const std::string& fc = "r",
-           const std::string ec = "k", Numeric head_length = 0.25, Numeric head_width = 0.1625) {
-    PyObject* obj_x = PyFloat_FromDouble(x);
-    PyObject* obj_y = PyFloat_FromDouble(y);
-    PyObject* obj_end_x = PyFloat_FromDouble(end_x);
-    PyObject* obj_end_y = PyFloat_FromDouble(end_y);
+// Reads values that lie stride bytes apart. A null data pointer stands
+// for the indices 0, 1, 2, ...
+template<typename Numeric>
+struct strided
+{
+    const Numeric* data;
+    std::ptrdiff_t stride;
+
+    const Numeric* address(size_t i) const
+    {
+        return reinterpret_cast<const Numeric*>(reinterpret_cast<const char*>(data) + i * stride);
+    }
+
+    double operator[](size_t i) const
+    {
+        if (!data) return static_cast<double>(i);
+        return static_cast<double>(*address(i));
+    }
+};
+
+// Binary search in the n ascending values of x: the index of the first one
+// that is not less than (or, for upper, greater than) value.
+template<typename X>
+size_t bound_index(const X& x, size_t n, double value, bool upper)
+{
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (upper ? !(value < x[mid]) : x[mid] < value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Whether the n values of x never decrease, which bound_index() and the
+// decimation buckets rely on. NaN counts as out of order.
+template<typename X>
+bool is_ascending(const X& x, size_t n)
+{
+    for (size_t i = 1; i < n; ++i)
+        if (!(x[i] >= x[i - 1])) return false;
+    return true;
+}
+
+// Splits the ascending x into buckets of the width of a pixel column, where
+// the columns divide left to right, and keeps the points with the smallest
+// and largest y of each, plus the first and last one for m4. A NaN y in a
+// bucket is kept as well, so that the line stays broken there.
+template<typename X, typename Y>
+void decimate_minmax(const X& x, const Y& y, size_t n, size_t columns, double left, double right,
+                     bool m4, std::vector<double>& xs, std::vector<double>& ys)
+{
+    if (!(right > left)) {
+        left = x[0];
+        right = x[n - 1];
+    }
+    const double scale = columns / (right - left);
+
+    size_t i = 0;
+    while (i < n) {
+        const double column = std::floor((x[i] - left) * scale);
+        const size_t first = i;
+        size_t low = i, high = i, gap = n;
+        double lo = INFINITY, hi = -INFINITY;
+        for (; i < n && (i == first || std::floor((x[i] - left) * scale) == column); ++i) {
+            const double v = y[i];
+            if (v < lo) { lo = v; low = i; }
+            if (v > hi) { hi = v; high = i; }
+            if (std::isnan(v) && gap == n) gap = i;
+        }
+
+        size_t picks[5]; // first, min, max, last and a NaN
+        size_t count = 0;
+        if (m4) picks[count++] = first;
+        picks[count++] = low;
+        picks[count++] = high;
+        if (m4) picks[count++] = i - 1;
+        if (gap != n) picks[count++] = gap;
+        std::sort(picks, picks + count);
+        for (size_t k = 0; k < count; ++k) {
+            if (k > 0 && picks[k] == picks[k - 1]) continue;
+            xs.push_back(x[picks[k]]);
+            ys.push_back(y[picks[k]]);
+        }
+    }
+}
+
+// Largest-Triangle-Three-Buckets: keeps the first and last point and, from
+// each of the buckets in between, the one spanning the largest triangle with
+// the previously kept point and the average of the next bucket. NaN values
+// are left out of the averages, and the first NaN of a bucket is kept, so
+// that the line stays broken there.
+template<typename X, typename Y>
+void decimate_lttb(const X& x, const Y& y, size_t n, size_t buckets,
+                   std::vector<double>& xs, std::vector<double>& ys)
+{
+    const double every = static_cast<double>(n - 2) / (buckets - 2);
+
+    size_t a = 0;
+    xs.push_back(x[0]);
+    ys.push_back(y[0]);
+    for (size_t i = 0; i + 2 < buckets; ++i) {
+        const size_t next_begin = static_cast<size_t>((i + 1) * every) + 1;
+        const size_t next_end = std::min(n, static_cast<size_t>((i + 2) * every) + 1);
+        double avgx = 0, avgy = 0;
+        size_t counted = 0;
+        for (size_t j = next_begin; j < next_end; ++j) {
+            if (std::isnan(y[j])) continue;
+            avgx += x[j];
+            avgy += y[j];
+            ++counted;
+        }
+
+        const size_t begin = static_cast<size_t>(i * every) + 1;
+        const size_t end = std::min(n - 1, next_begin);
+        const double ax = x[a];
+        const double ay = std::isnan(y[a]) && counted ? avgy / counted : y[a];
+        if (counted) {
+            avgx /= counted;
+            avgy /= counted;
+        } else {
+            avgx = x[next_end - 1];
+            avgy = ay;
+        }
+
+        size_t chosen = n, gap = n;
+        double largest = -1;
+        for (size_t j = begin; j < end; ++j) {
+            if (std::isnan(y[j])) {
+                if (gap == n) gap = j;
+                continue;
+            }
+            const double area = std::abs((ax - avgx) * (y[j] - ay) - (ax - x[j]) * (avgy - ay));
+            if (area > largest) { largest = area; chosen = j; }
+        }
+        if (gap < chosen) {
+            xs.push_back(x[gap]);
+            ys.push_back(y[gap]);
+        }
+        if (chosen != n) {
+            a = chosen;
+            xs.push_back(x[a]);
+            ys.push_back(y[a]);
+            if (gap != n && gap > chosen) {
+                xs.push_back(x[gap]);
+                ys.push_back(y[gap]);
+            }
+        }
+    }
+    xs.push_back(x[n - 1]);
+    ys.push_back(y[n - 1]);
+}
+
+// Reduces the n points to about `columns` pixel columns, spread over left to
+// right, the way mode says.
+template<typename X, typename Y>
+void decimate_line(const X& x, const Y& y, size_t n, size_t columns, double left, double right,
+                   Decimation mode, std::vector<double>& xs, std::vector<double>& ys)
+{
+    if (mode == Decimation::LTTB)
+        decimate_lttb(x, y, n, columns, xs, ys);
+    else
+        decimate_minmax(x, y, n, columns, left, right, mode == Decimation::M4, xs, ys);
+}
+
+// A reduced line whose full data is kept to reduce it anew whenever the
+// x limits of its axes change.
+struct zoom_series
+{
+    std::vector<double> x, y;
+    Decimation mode;
+    PyObject* line; // weak reference, the axes keep the callback alive
+
+    zoom_series() : mode(Decimation::None), line(NULL) {}
+
+    // moved, never copied: the points may be a huge series
+    zoom_series(zoom_series&& other)
+        : x(std::move(other.x)), y(std::move(other.y)), mode(other.mode), line(other.line)
+    {
+        other.line = NULL;
+    }
+    zoom_series(const zoom_series&) = delete;
+    zoom_series& operator=(const zoom_series&) = delete;
+
+    ~zoom_series() { Py_XDECREF(line); }
+};
+
+// The xlim_changed callback, with the zoom_series in self.
+inline PyObject* redecimate(PyObject* self, PyObject* args)
+{
+    zoom_series* series = static_cast<zoom_series*>(PyCapsule_GetPointer(self, "matplotlibcpp.zoom_series"));
+    PyObject* ax = PyTuple_GetItem(args, 0);
+    PyObject* line = series && ax ? PyObject_CallObject(series->line, NULL) : NULL;
+    if (!line) return NULL;
+    if (line == Py_None) return line; // the line is gone
+
+    PyObject* lim = PyObject_CallMethod(ax, const_cast<char*>("get_xlim"), NULL);
+    PyObject* bbox = PyObject_GetAttrString(ax, "bbox");
+    PyObject* width = bbox ? PyObject_GetAttrString(bbox, "width") : NULL;
+    Py_XDECREF(bbox);
+    if (!lim || !width) {
+        Py_XDECREF(lim);
+        Py_XDECREF(width);
+        Py_DECREF(line);
+        return NULL;
+    }
+    double left = PyFloat_AsDouble(PyTuple_GetItem(lim, 0));
+    double right = PyFloat_AsDouble(PyTuple_GetItem(lim, 1));
+    const size_t columns = std::max<size_t>(3, static_cast<size_t>(std::ceil(PyFloat_AsDouble(width))));
+    Py_DECREF(lim);
+    Py_DECREF(width);
+    if (left > right) std::swap(left, right); // inverted axis
+
+    // the visible slice and one point beyond either limit
+    const size_t n = series->x.size();
+    size_t first = bound_index(series->x, n, left, false);
+    size_t last = bound_index(series->x, n, right, true);
+    first = first > 0 ? first - 1 : 0;
+    last = std::min(n, last + 1);
+    if (first >= last)
+        first = last = 0;
+
+    PyObject *xarray, *yarray;
+    try {
+        std::vector<double> xs, ys;
+        if (series->mode != Decimation::None && last - first > 4 * columns) {
+            const strided<double> xv = {series->x.data() + first, sizeof(double)};
+            const strided<double> yv = {series->y.data() + first, sizeof(double)};
+            decimate_line(xv, yv, last - first, columns, left, right, series->mode, xs, ys);
+        } else {
+            xs.assign(series->x.begin() + first, series->x.begin() + last);
+            ys.assign(series->y.begin() + first, series->y.begin() + last);
+        }
+        // copies, since the series goes away with the callback
+        xarray = get_array(std::move(xs));
+        yarray = get_array(std::move(ys));
+    } catch (const std::exception& e) {
+        Py_DECREF(line);
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+
+    PyObject* res = PyObject_CallMethod(line, const_cast<char*>("set_data"), const_cast<char*>("(OO)"), xarray, yarray);
+    Py_DECREF(xarray);
+    Py_DECREF(yarray);
+    Py_DECREF(line);
+    return res;
+}
+
+inline void release_zoom_series(PyObject* capsule)
+{
+    delete static_cast<zoom_series*>(PyCapsule_GetPointer(capsule, "matplotlibcpp.zoom_series"));
+}
+
+// Hooks the first of the plotted lines up with redecimate().
+inline void follow_zoom(const std::shared_ptr<zoom_series>& pending, PyObject* lines)
+{
+    static PyMethodDef def = {"redecimate", &redecimate, METH_VARARGS, NULL};
+
+    PyObject* line = PySequence_GetItem(lines, 0);
+    PyObject* ax = line ? PyObject_GetAttrString(line, "axes") : NULL;
+    zoom_series* series = ax ? new zoom_series(std::move(*pending)) : NULL;
+    if (series) series->line = PyWeakref_NewRef(line, NULL);
+    Py_XDECREF(line);
+    if (!series || !series->line) {
+        delete series;
+        Py_XDECREF(ax);
+        throw std::runtime_error("Couldn't get the axes of the line.");
+    }
+
+    PyObject* capsule = PyCapsule_New(series, "matplotlibcpp.zoom_series", &release_zoom_series);
+    PyObject* callback = PyCFunction_New(&def, capsule);
+    Py_DECREF(capsule);
+    PyObject* callbacks = PyObject_GetAttrString(ax, "callbacks");
+    Py_DECREF(ax);
+    PyObject* res = callbacks ? PyObject_CallMethod(callbacks, const_cast<char*>("connect"),
+                                                    const_cast<char*>("(sO)"), "xlim_changed", callback) : NULL;
+    Py_XDECREF(callbacks);
+    Py_DECREF(callback);
+    if (!res) throw std::runtime_error("Couldn't connect to xlim_changed.");
+    Py_DECREF(res);
+}
+
+// Distance of point i from the segment from a to b.
+inline double segment_distance(const double* x, const double* y, size_t a, size_t b, size_t i)
+{
+    const double dx = x[b] - x[a], dy = y[b] - y[a];
+    const double length = dx * dx + dy * dy;
+    double t = length > 0 ? ((x[i] - x[a]) * dx + (y[i] - y[a]) * dy) / length : 0;
+    t = std::max(0.0, std::min(1.0, t));
+    const double ex = x[a] + t * dx - x[i], ey = y[a] + t * dy - y[i];
+    return std::sqrt(ex * ex + ey * ey);
+}
+
+// Ramer-Douglas-Peucker: marks the points of [first, last] to keep so that
+// no dropped one is further than tolerance from the simplified path.
+inline void simplify_rdp(const double* x, const double* y, size_t first, size_t last, double tolerance,
+                         std::vector<char>& keep)
+{
+    std::fill(keep.begin() + first, keep.begin() + last + 1, 0);
+    keep[first] = keep[last] = 1;
+    std::vector<std::pair<size_t, size_t>> pending(1, std::make_pair(first, last));
+    while (!pending.empty()) {
+        const size_t a = pending.back().first, b = pending.back().second;
+        pending.pop_back();
+        double largest = -1;
+        size_t furthest = a;
+        for (size_t i = a + 1; i < b; ++i) {
+            const double d = segment_distance(x, y, a, b, i);
+            if (d > largest) { largest = d; furthest = i; }
+        }
+        if (largest > tolerance) {
+            keep[furthest] = 1;
+            pending.push_back(std::make_pair(a, furthest));
+            pending.push_back(std::make_pair(furthest, b));
+        }
+    }
+}
+
+// Visvalingam-Whyatt: drops the points of [first, last] whose triangle with
+// their neighbours is the smallest, as long as it is smaller than
+// tolerance^2 / 2, i.e. a deviation of tolerance over a base of tolerance.
+// A thin spike spans a small triangle however far it reaches, so a point is
+// only dropped if it and the points dropped next to it before all stay
+// within tolerance of the new segment, which keeps the same guarantee as RDP.
+inline void simplify_visvalingam(const double* x, const double* y, size_t first, size_t last, double tolerance,
+                                 std::vector<char>& keep)
+{
+    // indices relative to first from here on
+    const size_t n = last - first + 1;
+    x += first;
+    y += first;
+    char* kept = &keep[first];
+
+    const double threshold = 0.5 * tolerance * tolerance;
+    std::vector<size_t> prev(n), next(n);
+    std::vector<double> area(n, INFINITY);
+    auto triangle = [&](size_t i) {
+        return 0.5 * std::fabs((x[i] - x[prev[i]]) * (y[next[i]] - y[prev[i]]) -
+                               (x[next[i]] - x[prev[i]]) * (y[i] - y[prev[i]]));
+    };
+
+    typedef std::pair<double, size_t> entry;
+    std::vector<entry> heap;
+    for (size_t i = 0; i < n; ++i) {
+        kept[i] = 1;
+        prev[i] = i > 0 ? i - 1 : i;
+        next[i] = i + 1 < n ? i + 1 : i;
+        if (i > 0 && i + 1 < n) {
+            area[i] = triangle(i);
+            heap.push_back(entry(area[i], i));
+        }
+    }
+    std::greater<entry> later;
+    std::make_heap(heap.begin(), heap.end(), later);
+    while (!heap.empty() && heap.front().first < threshold) {
+        const entry smallest = heap.front();
+        std::pop_heap(heap.begin(), heap.end(), later);
+        heap.pop_back();
+        const size_t i = smallest.second;
+        if (!kept[i] || smallest.first != area[i]) continue; // stale entry
+
+        bool close = true;
+        for (size_t k = prev[i] + 1; close && k < next[i]; ++k)
+            close = segment_distance(x, y, prev[i], next[i], k) <= tolerance;
+        if (!close) {
+            area[i] = INFINITY; // kept for good
+            continue;
+        }
+
+        kept[i] = 0;
+        next[prev[i]] = next[i];
+        prev[next[i]] = prev[i];
+        for (size_t j : {prev[i], next[i]}) {
+            if (j == 0 || j + 1 == n) continue;
+            area[j] = triangle(j);
+            heap.push_back(entry(area[j], j));
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+    }
+}
+
+const size_t visvalingam_piece = 1 << 13;
+
+// The indices of the points of a path, given in pixels, that simplification
+// keeps. Runs of finite points are simplified separately and NaNs, which
+// break the path, are kept. Long paths are split into pieces, one per
+// thread, whose ends are kept, if parallel is set.
+inline std::vector<size_t> simplify_path(const std::vector<double>& x, const std::vector<double>& y,
+                                         Simplification mode, double tolerance, bool parallel)
+{
+    const size_t n = x.size();
+    std::vector<char> keep(n, 1);
+    auto simplify = [&](size_t first, size_t last) {
+        for (size_t begin = first; begin < last; ) {
+            if (!std::isfinite(x[begin]) || !std::isfinite(y[begin])) { ++begin; continue; }
+            size_t end = begin + 1;
+            while (end < last && std::isfinite(x[end]) && std::isfinite(y[end])) ++end;
+            if (mode == Simplification::RDP) {
+                if (end - begin > 2)
+                    simplify_rdp(x.data(), y.data(), begin, end - 1, tolerance, keep);
+            } else {
+                // in pieces whose heaps stay in the cache, sharing their ends
+                for (size_t piece = begin; piece + 2 < end; piece += visvalingam_piece)
+                    simplify_visvalingam(x.data(), y.data(), piece, std::min(end - 1, piece + visvalingam_piece),
+                                         tolerance, keep);
+            }
+            begin = end;
+        }
+    };
+    const size_t parts = parallel ? std::max<size_t>(1, std::min(thread_count(), n / parallel_min_chunk)) : 1;
+    parallel_for(parts, [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p)
+            simplify(n * p / parts, n * (p + 1) / parts);
+    }, n / parts);
+
+    std::vector<size_t> kept;
+    for (size_t i = 0; i < n; ++i)
+        if (keep[i]) kept.push_back(i);
+    return kept;
+}
+
+// Pixels per data unit along x and y of the current axes, taking the range
+// of the data where the limits still autoscale, since the view then spans
+// at least that. Returns false if an axis isn't linear or a range is empty.
+inline bool pixel_scale(double xmin, double xmax, double ymin, double ymax, double& sx, double& sy)
+{
+    PyObject* ax = gca();
+    PyObject* xscale = call_now(axes_method(ax, "get_xscale"), {});
+    PyObject* yscale = call_now(axes_method(ax, "get_yscale"), {});
+    PyObject* linear_name = PyString_FromString("linear");
+    Py_DECREF(ax);
+    const bool linear = xscale && yscale &&
+        PyObject_RichCompareBool(xscale, linear_name, Py_EQ) == 1 &&
+        PyObject_RichCompareBool(yscale, linear_name, Py_EQ) == 1;
+    Py_DECREF(linear_name);
+    Py_XDECREF(xscale);
+    Py_XDECREF(yscale);
+    if (!linear) {
+        PyErr_Clear();
+        return false;
+    }
+
+    double width, height, lo, hi;
+    axes_pixel_size(width, height);
+    if (fixed_lim('x', lo, hi)) { xmin = lo; xmax = hi; }
+    if (fixed_lim('y', lo, hi)) { ymin = lo; ymax = hi; }
+    if (!(xmax > xmin) || !(ymax > ymin)) return false;
+    sx = width / (xmax - xmin);
+    sy = height / (ymax - ymin);
+    return true;
+}
+
+// Converts the paths to pixels and simplifies each of them according to
+// set_simplification(), several paths at once if there are many. Returns
+// false if there is nothing to simplify.
+template<typename Path>
+bool simplify_paths(const std::vector<Path>& paths, std::vector<std::vector<size_t>>& kept)
+{
+    const Simplification mode = simplification_mode();
+    if (mode == Simplification::None) return false;
+
+    double xmin = INFINITY, xmax = -INFINITY, ymin = INFINITY, ymax = -INFINITY;
+    size_t total = 0;
+    for (const Path& path : paths) {
+        for (size_t i = 0; i < path.n; ++i) {
+            const double x = path.x[i], y = path.y[i];
+            if (!std::isfinite(x) || !std::isfinite(y)) continue;
+            xmin = std::min(xmin, x); xmax = std::max(xmax, x);
+            ymin = std::min(ymin, y); ymax = std::max(ymax, y);
+        }
+        total += path.n;
+    }
+    double sx, sy;
+    if (total < 3 * paths.size() || !pixel_scale(xmin, xmax, ymin, ymax, sx, sy)) return false;
+
+    const double tolerance = simplification_tolerance();
+    const bool parallel = paths.size() == 1;
+    kept.resize(paths.size());
+    parallel_for(paths.size(), [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            const Path& path = paths[k];
+            std::vector<double> px(path.n), py(path.n);
+            for (size_t i = 0; i < path.n; ++i) {
+                px[i] = path.x[i] * sx;
+                py[i] = path.y[i] * sy;
+            }
+            kept[k] = simplify_path(px, py, mode, tolerance, parallel);
+        }
+    }, paths.empty() ? 0 : total / paths.size());
+    return true;
+}
+
+template<typename NumericX, typename NumericY>
+struct strided_path
+{
+    strided<NumericX> x;
+    strided<NumericY> y;
+    size_t n;
+};
+
+// Copies the kept points of a path.
+template<typename Path>
+void get_kept_arrays(const Path& path, const std::vector<size_t>& kept, PyObject*& xarray, PyObject*& yarray)
+{
+    std::vector<double> xs(kept.size()), ys(kept.size());
+    for (size_t i = 0; i < kept.size(); ++i) {
+        xs[i] = path.x[kept[i]];
+        ys[i] = path.y[kept[i]];
+    }
+    xarray = get_array(std::move(xs));
+    yarray = get_array(std::move(ys));
+}
+
+// Builds the arrays for the n vertices of a path, simplified according to
+// set_simplification().
+template<typename NumericX, typename NumericY>
+void get_path_arrays(const NumericX* x, std::ptrdiff_t xstride, const NumericY* y, std::ptrdiff_t ystride,
+                     size_t n, PyObject*& xarray, PyObject*& yarray)
+{
+    typedef strided_path<NumericX, NumericY> Path;
+    const std::vector<Path> paths(1, Path{{x, xstride}, {y, ystride}, n});
+    std::vector<std::vector<size_t>> kept;
+    if (simplify_paths(paths, kept) && kept[0].size() < n) {
+        get_kept_arrays(paths[0], kept[0], xarray, yarray);
+        return;
+    }
+    xarray = get_array(x, n, xstride);
+    yarray = get_array(y, n, ystride);
+}
+
+// Builds the arrays for a line of n points. With set_viewport_culling(),
+// only the part within fixed x limits is passed on, and it is decimated
+// according to set_decimation() if it has more points than the current axes
+// have pixel columns. A null x stands for 0, 1, 2, ... and stays null unless
+// points were dropped. With set_interactive_decimation(), a line that was
+// reduced keeps a copy of all points to be reduced anew on every zoom.
+template<typename NumericX, typename NumericY>
+void get_line_arrays(const NumericX* x, std::ptrdiff_t xstride, const NumericY* y, std::ptrdiff_t ystride,
+                     size_t n, PyObject*& xarray, PyObject*& yarray)
+{
+    const NumericY* const all_y = y;
+    const size_t all_n = n;
+
+    double left = 0, right = 0;
+    bool culled = false;
+    const strided<NumericX> all = {x, xstride};
+    if (viewport_culling() && x && n > 2 && fixed_lim('x', left, right) && is_ascending(all, n)) {
+        // keep one point beyond either limit, so the line runs off the edges
+        size_t first = bound_index(all, n, left, false);
+        size_t last = bound_index(all, n, right, true);
+        first = first > 0 ? first - 1 : 0;
+        last = std::min(n, last + 1);
+        if (first >= last)
+            first = last = 0;
+
+        x = all.address(first);
+        y = strided<NumericY>{y, ystride}.address(first);
+        culled = n != last - first;
+        n = last - first;
+    }
+
+    const Decimation mode = decimation_mode();
+    const strided<NumericX> xv = {x, xstride};
+    const strided<NumericY> yv = {y, ystride};
+
+    bool decimate = mode != Decimation::None && n > 4 && xv[n - 1] > xv[0];
+    size_t columns = 0;
+    if (decimate) {
+        double width, height;
+        axes_pixel_size(width, height);
+        columns = std::max<size_t>(3, static_cast<size_t>(std::ceil(width)));
+        decimate = n > 4 * columns;
+    }
+    // the buckets are ranges of x, which only works if x is ascending
+    decimate = decimate && (culled || is_ascending(xv, n));
+
+    std::function<void(PyObject*)> hook;
+    if ((culled || decimate) && interactive_decimation()) {
+        // culling checked all of x to be ascending, and without culling
+        // decimation checked the same points
+        const strided<NumericY> ay = {all_y, ystride};
+        std::shared_ptr<zoom_series> series = std::make_shared<zoom_series>();
+        series->mode = mode;
+        series->line = NULL;
+        series->x.resize(all_n);
+        series->y.resize(all_n);
+        for (size_t i = 0; i < all_n; ++i) {
+            series->x[i] = all[i];
+            series->y[i] = ay[i];
+        }
+        hook = [series](PyObject* lines) { follow_zoom(series, lines); };
+    }
+
+    if (!decimate && x) {
+        get_path_arrays(x, xstride, y, ystride, n, xarray, yarray);
+    } else if (!decimate) {
+        xarray = NULL;
+        yarray = get_array(y, n, ystride);
+    } else {
+        // the buckets of M4 and MinMax line up with the pixel columns of
+        // the x range the axes will show
+        if (mode != Decimation::LTTB)
+            shown_x_range(xv[0], xv[n - 1], left, right);
+        std::vector<double> xs, ys;
+        decimate_line(xv, yv, n, columns, left, right, mode, xs, ys);
+
+        xarray = get_array(std::move(xs));
+        yarray = get_array(std::move(ys));
+    }
+
+    // installed last, so that a failure above leaves no hook behind for
+    // some later, unrelated plot()
+    plot_hook() = std::move(hook);
+}
+
+} // namespace detail
+
+/// Lets plot() and named_plot() reduce sorted series with many more points
+/// than the current axes have pixel columns before handing them over to
+/// matplotlib. M4 keeps the first, last, lowest and highest point per column
+/// and draws a line that looks the same as the full data, MinMax keeps only
+/// the extremes and LTTB one representative point per column. The columns of
+/// M4 and MinMax are those of the x range the axes show after the line is
+/// added, i.e. the fixed limits or the data limits plus the margins; once
+/// the limits or the size of the axes change, the line only stays exact with
+/// set_interactive_decimation(). A NaN, which breaks the line, is kept in
+/// every mode. Data that is moved or shared with matplotlib is always passed
+/// on as is.
+inline void set_decimation(Decimation mode)
+{
+    detail::decimation_mode() = mode;
+}
+
+/// Lets the same plot() and named_plot() calls pass only the slice of x that
+/// is visible, plus one point on either side, once the x limits have been
+/// fixed with xlim(left, right). The slice is found by binary search, so
+/// only series whose x is ascending are culled; others are passed on whole.
+/// The slice is not extended when the view is moved later.
+inline void set_viewport_culling(bool enabled)
+{
+    detail::viewport_culling() = enabled;
+}
+
+/// Keeps a copy of every line that set_decimation() or
+/// set_viewport_culling() reduced, and reduces it anew for the visible x
+/// range whenever the x limits of its axes change, e.g. by zooming or
+/// panning with an interactive backend. So each zoom level shows the data
+/// at full detail while only about four points per pixel column are sent.
+inline void set_interactive_decimation(bool enabled)
+{
+    detail::interactive_decimation() = enabled;
+}
+
+/// Lets plot(), named_plot() and fill() drop vertices of paths given by
+/// vectors or pointers as long as the drawn path moves by less than
+/// tolerance pixels of the current axes, e.g. for outlines with millions of
+/// nearly collinear vertices. RDP keeps every vertex that is further than
+/// that from the simplified path, Visvalingam drops the vertices spanning
+/// the smallest triangles first, with the same bound on how far the path
+/// may move. Only linear axes are simplified.
+inline void set_simplification(Simplification mode, double tolerance = 0.25)
+{
+    detail::simplification_mode() = mode;
+    detail::simplification_tolerance() = tolerance;
+}
+
+/// Counts values into bins in C++, so that only the edges and the counts
+/// have to be handed over to matplotlib. add() may be called again and again,
+/// e.g. for every chunk of a stream, without binning earlier data anew.
+/// Like numpy, every bin includes its left edge and the last one its right
+/// edge as well. Values outside the edges are not counted.
+class Histogram
+{
+public:
+    /// `bins` bins of equal width covering [lo, hi]
+    static Histogram linear(size_t bins, double lo, double hi)
+    {
+        Histogram h(Linear, bins, lo, hi);
+        for (size_t i = 0; i <= bins; ++i)
+            h.bin_edges[i] = lo + (hi - lo) * i / bins;
+        return h;
+    }
+
+    /// `bins` bins of equal width on a log scale covering [lo, hi], lo > 0
+    static Histogram log(size_t bins, double lo, double hi)
+    {
+        Histogram h(Log, bins, std::log(lo), std::log(hi));
+        for (size_t i = 0; i <= bins; ++i)
+            h.bin_edges[i] = lo * std::pow(hi / lo, static_cast<double>(i) / bins);
+        return h;
+    }
+
+    /// bins between any two consecutive of the given ascending edges
+    explicit Histogram(const std::vector<double>& edges)
+        : scale(Explicit), offset(0), factor(0), bin_edges(edges),
+          bin_counts(edges.size() > 1 ? edges.size() - 1 : 0, 0)
+    {
+        if (edges.size() < 2) throw std::runtime_error("A histogram needs at least two edges");
+    }
+
+    template<typename Numeric>
+    void add(const Numeric* data, size_t n, std::ptrdiff_t stride = sizeof(Numeric))
+    {
+        const size_t bins = bin_counts.size();
+        const size_t parts = std::max<size_t>(1, std::min(detail::thread_count(), n / detail::parallel_min_chunk));
+        const detail::strided<Numeric> values = {data, stride};
+
+        // every thread counts into its own copy of the bins
+        std::vector<uint64_t> partial(parts * bins, 0);
+        detail::parallel_for(parts, [&](size_t begin, size_t end) {
+            for (size_t p = begin; p < end; ++p)
+                count(values, n * p / parts, n * (p + 1) / parts, &partial[p * bins]);
+        }, n / parts);
+
+        for (size_t p = 0; p < parts; ++p)
+            for (size_t b = 0; b < bins; ++b)
+                bin_counts[b] += partial[p * bins + b];
+    }
+
+    template<typename Numeric>
+    void add(const std::vector<Numeric>& data)
+    {
+        add(data.data(), data.size());
+    }
+
+    void clear()
+    {
+        std::fill(bin_counts.begin(), bin_counts.end(), 0);
+    }
+
+    const std::vector<double>& edges() const { return bin_edges; }
+    const std::vector<uint64_t>& counts() const { return bin_counts; }
+
+private:
+    enum Scale { Linear, Log, Explicit };
+
+    // lo and hi are already log transformed for the log scale
+    Histogram(Scale scale, size_t bins, double lo, double hi)
+        : scale(scale), offset(lo), factor(bins / (hi - lo)), bin_edges(bins + 1), bin_counts(bins, 0)
+    {
+        if (bins == 0 || !(hi > lo)) throw std::runtime_error("A histogram needs bins and lo < hi");
+    }
+
+    // The bin index of every value is computed first, a block at a time,
+    // in a loop the compiler can vectorize for the equal width scales. Only
+    // then the bins are incremented.
+    template<typename Values>
+    void count(const Values& values, size_t begin, size_t end, uint64_t* counts) const
+    {
+        const size_t block = 256;
+        const std::ptrdiff_t bins = bin_counts.size();
+        const double last = bin_edges.back();
+        std::ptrdiff_t index[block];
+
+        for (size_t i = begin; i < end; i += block) {
+            const size_t m = std::min(block, end - i);
+            if (scale == Explicit) {
+                for (size_t k = 0; k < m; ++k) {
+                    const double v = values[i + k];
+                    index[k] = std::upper_bound(bin_edges.begin(), bin_edges.end(), v) - bin_edges.begin() - 1;
+                    if (v == last) index[k] = bins - 1;
+                }
+            } else {
+                for (size_t k = 0; k < m; ++k) {
+                    const double v = values[i + k];
+                    const double t = ((scale == Log ? std::log(v) : v) - offset) * factor;
+                    index[k] = t >= 0 && t < bins ? static_cast<std::ptrdiff_t>(t) : -1;
+                    if (v == last) index[k] = bins - 1;
+                }
+            }
+            for (size_t k = 0; k < m; ++k)
+                if (index[k] >= 0 && index[k] < bins) ++counts[index[k]];
+        }
+    }
+
+    Scale scale;
+    double offset, factor;
+    std::vector<double> bin_edges;
+    std::vector<uint64_t> bin_counts;
+};
+
+namespace detail {
+
+// What hist() makes of raw data: `bins` bins spanning the finite values.
+template<typename Numeric>
+Histogram auto_histogram(const Numeric* y, size_t n, long bins, std::ptrdiff_t ystride)
+{
+    const strided<Numeric> values = {y, ystride};
+    double lo = INFINITY, hi = -INFINITY;
+    for (size_t i = 0; i < n; ++i) {
+        const double v = values[i];
+        if (!std::isfinite(v)) continue;
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+    }
+    if (!(hi >= lo)) { lo = 0; hi = 1; }
+    if (hi == lo) { lo -= 0.5; hi += 0.5; } // numpy does the same
+
+    Histogram h = Histogram::linear(static_cast<size_t>(std::max(1L, bins)), lo, hi);
+    h.add(y, n, ystride);
+    return h;
+}
+
+// Draws finished bins, with stairs() where matplotlib has it and bar()
+// otherwise. An empty label is left out.
+inline bool hist(const Histogram& h, const std::string& color, double alpha, bool cumulative, const std::string& label)
+{
+    const std::vector<double>& edges = h.edges();
+    std::vector<double> counts(h.counts().begin(), h.counts().end());
+    if (cumulative)
+        std::partial_sum(counts.begin(), counts.end(), counts.begin());
+
+    PyObject* kwargs = PyDict_New();
+    if (!label.empty())
+        PyDict_SetItemString(kwargs, "label", PyString_FromString(label.c_str()));
+    PyDict_SetItemString(kwargs, "color", PyString_FromString(color.c_str()));
+    PyDict_SetItemString(kwargs, "alpha", PyFloat_FromDouble(alpha));
+
+    PyObject* fn;
+    PyObject* plot_args[2];
+    if (detail::_interpreter::get().s_python_function_stairs) {
+        fn = detail::_interpreter::get().s_python_function_stairs;
+        PyDict_SetItemString(kwargs, "fill", Py_True);
+        plot_args[0] = get_array(std::move(counts));
+        // copied, since the histogram may be a temporary and matplotlib
+        // keeps the array it is given
+        plot_args[1] = get_array(std::vector<double>(edges));
+    } else {
+        fn = detail::_interpreter::get().s_python_function_bar;
+        std::vector<double> widths(counts.size());
+        for (size_t i = 0; i < widths.size(); ++i)
+            widths[i] = edges[i + 1] - edges[i];
+        PyObject* warray = get_array(std::move(widths));
+        PyDict_SetItemString(kwargs, "width", warray);
+        Py_DECREF(warray);
+        PyDict_SetItemString(kwargs, "align", PyString_FromString("edge"));
+        plot_args[0] = get_array(std::vector<double>(edges.begin(), edges.end() - 1));
+        plot_args[1] = get_array(std::move(counts));
+    }
+
+    PyObject* res = detail::call(fn, plot_args, 2, kwargs);
+
+    Py_DECREF(kwargs);
+    if(res) Py_DECREF(res);
+
+    return res;
+}
+
+} // namespace detail
+
+/// Plot a line through the given x and y data points..
+///
+/// See: https://matplotlib.org/3.2.1/api/_as_gen/matplotlib.pyplot.plot.html
+template<typename Numeric>
+bool plot(const std::vector<Numeric> &x, const std::vector<Numeric> &y, const Keywords& keywords)
+{
+    assert(x.size() == y.size());
+
+    detail::_interpreter::get();
+
+    // using numpy arrays
+    PyObject *xarray, *yarray;
+    detail::get_line_arrays(x.data(), sizeof(Numeric), y.data(), sizeof(Numeric), x.size(), xarray, yarray);
+    return detail::plot(detail::_interpreter::get().s_python_function_plot, xarray, yarray, keywords);
+}
+
+/// Same as above, but the data is moved into the plot instead of being
+/// borrowed, so x and y may go out of scope while matplotlib still uses them.
+template<typename Numeric>
+bool plot(std::vector<Numeric> &&x, std::vector<Numeric> &&y, const Keywords& keywords)
+{
+    assert(x.size() == y.size());
+
+    detail::_interpreter::get();
+
+    return detail::plot(detail::_interpreter::get().s_python_function_plot,
+                        detail::get_array(std::move(x)), detail::get_array(std::move(y)), keywords);
+}
+
+/// Plot n points whose coordinates are read from x and y, with consecutive
+/// values being xstride and ystride bytes apart. The memory is passed to
+/// matplotlib without copying it, so it has to stay valid while being used.
+///
+/// Example: plot(&recs[0].time, &recs[0].price, recs.size(), Keywords{{"label", "price"}}, sizeof(Rec), sizeof(Rec))
+///
+/// Spell out Keywords, or pass a format string instead: a bare {} matches
+/// both and is ambiguous.
+template<typename NumericX, typename NumericY>
+bool plot(const NumericX* x, const NumericY* y, size_t n, const Keywords& keywords,
+          std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
+
+    PyObject *xarray, *yarray;
+    detail::get_line_arrays(x, xstride, y, ystride, n, xarray, yarray);
+    return detail::plot(detail::_interpreter::get().s_python_function_plot, xarray, yarray, keywords);
+}
+
+/// How plot_surface() reduces large grids, see set_surface_lod().
+enum class SurfaceLOD { None, Stride, Resample, Adaptive };
+
+namespace detail {
+
+inline SurfaceLOD& surface_lod_mode()
+{
+    static SurfaceLOD mode = SurfaceLOD::None;
+    return mode;
+}
+
+// Most cells plot_surface() draws with an LOD mode set, 0 to derive it from
+// the size of the figure.
+inline size_t& surface_max_polygons()
+{
+    static size_t polygons = 0;
+    return polygons;
+}
+
+// Figure fig_number, or a new figure if there is none with that number, as
+// a new reference.
+inline PyObject* find_figure(long fig_number)
+{
+  PyObject *fig_exists = call_now(_interpreter::get().s_python_function_fignum_exists,
+                                  {PyLong_FromLong(fig_number)});
+  if (!fig_exists) throw std::runtime_error("Call to fignum_exists() failed.");
+  const bool exists = PyObject_IsTrue(fig_exists);
+  Py_DECREF(fig_exists);
+
+  PyObject *fig = exists
+      ? call_now(_interpreter::get().s_python_function_figure, {PyLong_FromLong(fig_number)})
+      : call_now(_interpreter::get().s_python_function_figure, {});
+  if (!fig) throw std::runtime_error("Call to figure() failed.");
+  return fig;
+}
+
+// The axes of fig that 3d plots go into, as a new reference: its current
+// axes if they are 3d already, a new 3d subplot otherwise. That is what
+// gca(projection='3d') did before matplotlib 3.4 stopped accepting it.
+inline PyObject* axes3d(PyObject *fig)
+{
+  // We lazily load the modules here the first time this function is called
+  // because I'm not sure that we can assume "matplotlib installed" implies
+  // "mpl_toolkits installed" on all platforms, and we don't want to require
+  // it for people who don't need 3d plots.
+  static PyObject *mpl_toolkitsmod = nullptr, *axis3dmod = nullptr;
+  if (!mpl_toolkitsmod) {
+    detail::_interpreter::get();
+
+    PyObject* mpl_toolkits = PyString_FromString("mpl_toolkits");
+    PyObject* axis3d = PyString_FromString("mpl_toolkits.mplot3d");
+    if (!mpl_toolkits || !axis3d) { throw std::runtime_error("couldnt create string"); }
+
+    mpl_toolkitsmod = PyImport_Import(mpl_toolkits);
+    Py_DECREF(mpl_toolkits);
+    if (!mpl_toolkitsmod) { throw std::runtime_error("Error loading module mpl_toolkits!"); }
+
+    axis3dmod = PyImport_Import(axis3d);
+    Py_DECREF(axis3d);
+    if (!axis3dmod) { throw std::runtime_error("Error loading module mpl_toolkits.mplot3d!"); }
+  }
+
+  flush_batch();
+
+  PyObject *axes = PyObject_GetAttrString(fig, "axes");
+  PyObject *ax = NULL;
+  if (axes && PySequence_Size(axes) > 0) {
+    ax = PyObject_CallMethod(fig, const_cast<char*>("gca"), NULL);
+    PyObject *name = ax ? PyObject_GetAttrString(ax, "name") : NULL;
+    PyObject *name3d = PyString_FromString("3d");
+    if (!name || PyObject_RichCompareBool(name, name3d, Py_EQ) != 1)
+      Py_CLEAR(ax);
+    Py_XDECREF(name);
+    Py_DECREF(name3d);
+  }
+  Py_XDECREF(axes);
+  PyErr_Clear();
+
+  if (!ax) {
+    PyObject *kwargs = PyDict_New();
+    PyObject *projection = PyString_FromString("3d");
+    PyDict_SetItemString(kwargs, "projection", projection);
+    Py_DECREF(projection);
+    PyObject *add_subplot = PyObject_GetAttrString(fig, "add_subplot");
+    ax = add_subplot ? call_now(add_subplot, {}, kwargs) : NULL;
+    Py_XDECREF(add_subplot);
+    Py_DECREF(kwargs);
+    if (!ax) throw std::runtime_error("Couldn't add 3d axes to the figure.");
+  }
+  return ax;
+}
+
+inline void plot_surface(PyObject *xarray, PyObject *yarray, PyObject *zarray,
+                         const Keywords& keywords,
+                         const long fig_number, long rstride = 1, long cstride = 1)
+{
+  // Build up the kw args.
+  PyObject *kwargs = PyDict_New();
+  PyDict_SetItemString(kwargs, "rstride", PyInt_FromLong(rstride));
+  PyDict_SetItemString(kwargs, "cstride", PyInt_FromLong(cstride));
+
+  // colormaps can be given by name, which spares importing matplotlib.cm
+  PyObject *python_colormap_coolwarm = PyString_FromString("coolwarm");
+  PyDict_SetItemString(kwargs, "cmap", python_colormap_coolwarm);
+  Py_DECREF(python_colormap_coolwarm);
+
+  keywords.add_to(kwargs);
+  // numbers given as strings, like "0.5", still work for these
+  for (const char* number : {"linewidth", "alpha"}) {
+    Keywords::const_iterator it = keywords.find(number);
+    if (it != keywords.end() && it->second.is_string())
+      PyDict_SetItemString(kwargs, number, PyFloat_FromDouble(it->second.to_double()));
+  }
+
+  PyObject *fig = find_figure(fig_number);
+  PyObject *axis = axes3d(fig);
+  Py_DECREF(fig);
+
+  PyObject *res = detail::call(axes_method(axis, "plot_surface"), {xarray, yarray, zarray}, kwargs);
+  Py_DECREF(axis);
+  Py_DECREF(kwargs);
+  if (!res) throw std::runtime_error("failed surface");
+  Py_DECREF(res);
+}
+
+// Size of figure fig_number in pixels, or the size a new figure gets if
+// there is no such figure yet, which is what plot_surface() draws into.
+inline void figure_pixel_size(long fig_number, double& width, double& height)
+{
+  PyObject *fig_exists = detail::call_now(
+      detail::_interpreter::get().s_python_function_fignum_exists, {PyLong_FromLong(fig_number)});
+  if (!fig_exists) throw std::runtime_error("Call to fignum_exists() failed.");
+
+  PyObject *size;
+  if (PyObject_IsTrue(fig_exists)) {
+    PyObject *fig = detail::call_now(detail::_interpreter::get().s_python_function_figure,
+                                     {PyLong_FromLong(fig_number)});
+    if (!fig) {
+      Py_DECREF(fig_exists);
+      throw std::runtime_error("Call to figure() failed.");
+    }
+    PyObject *bbox = PyObject_GetAttrString(fig, "bbox");
+    Py_DECREF(fig);
+    size = bbox ? PyObject_GetAttrString(bbox, "size") : NULL;
+    Py_XDECREF(bbox);
+  } else {
+    PyObject *figsize = PyMapping_GetItemString(detail::_interpreter::get().s_python_function_rcparams,
+                                                const_cast<char*>("figure.figsize"));
+    PyObject *dpi = PyMapping_GetItemString(detail::_interpreter::get().s_python_function_rcparams,
+                                            const_cast<char*>("figure.dpi"));
+    size = NULL;
+    if (figsize && dpi) {
+      const double scale = PyFloat_AsDouble(dpi);
+      PyObject *w = PySequence_GetItem(figsize, 0), *h = PySequence_GetItem(figsize, 1);
+      if (w && h)
+        size = Py_BuildValue("(dd)", PyFloat_AsDouble(w) * scale, PyFloat_AsDouble(h) * scale);
+      Py_XDECREF(w);
+      Py_XDECREF(h);
+    }
+    Py_XDECREF(figsize);
+    Py_XDECREF(dpi);
+  }
+  Py_DECREF(fig_exists);
+  if (!size) throw std::runtime_error("Couldn't get the size of the figure.");
+
+  PyObject *w = PySequence_GetItem(size, 0), *h = PySequence_GetItem(size, 1);
+  Py_DECREF(size);
+  if (!w || !h) {
+    Py_XDECREF(w);
+    Py_XDECREF(h);
+    throw std::runtime_error("Couldn't get the size of the figure.");
+  }
+  width = PyFloat_AsDouble(w);
+  height = PyFloat_AsDouble(h);
+  Py_DECREF(w);
+  Py_DECREF(h);
+}
+
+// Picks count of the indices [0, n), always including the first and the
+// last, so that the gaps between them span equal shares of the weights.
+// With equal weights they are spread evenly.
+inline std::vector<size_t> pick_lines(size_t n, size_t count, const std::vector<double>& weight)
+{
+  std::vector<size_t> picked;
+  if (count >= n) {
+    picked.resize(n);
+    std::iota(picked.begin(), picked.end(), size_t(0));
+    return picked;
+  }
+
+  std::vector<double> cumulative(n, 0.0);
+  for (size_t i = 1; i < n; ++i)
+    cumulative[i] = cumulative[i - 1] + 0.5 * (weight[i - 1] + weight[i]);
+
+  for (size_t k = 0; k < count; ++k) {
+    const double target = cumulative[n - 1] * k / (count - 1);
+    size_t i = std::lower_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin();
+    i = std::min(i, n - 1);
+    if (picked.empty() || picked.back() != i)
+      picked.push_back(i);
+  }
+  if (picked.back() != n - 1)
+    picked.push_back(n - 1);
+  return picked;
+}
+
+// How much z bends along every row and column: the summed absolute second
+// differences across it, plus their mean, so flat parts keep some lines too.
+template<typename Grid>
+void surface_curvature(const Grid& z, size_t rows, size_t cols,
+                       std::vector<double>& row_weight, std::vector<double>& col_weight)
+{
+  const size_t parts = std::max<size_t>(1, std::min(thread_count(), rows * cols / parallel_min_chunk));
+  row_weight.assign(rows, 0.0);
+  std::vector<double> partial(parts * cols, 0.0);
+
+  parallel_for(parts, [&](size_t begin, size_t end) {
+    for (size_t p = begin; p < end; ++p) {
+      double* cw = &partial[p * cols];
+      for (size_t i = rows * p / parts; i < rows * (p + 1) / parts; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+          const double c = z(i, j);
+          if (i > 0 && i + 1 < rows) {
+            const double d = z(i - 1, j) - 2 * c + z(i + 1, j);
+            if (std::isfinite(d)) row_weight[i] += std::fabs(d);
+          }
+          if (j > 0 && j + 1 < cols) {
+            const double d = z(i, j - 1) - 2 * c + z(i, j + 1);
+            if (std::isfinite(d)) cw[j] += std::fabs(d);
+          }
+        }
+      }
+    }
+  }, rows * cols / parts);
+
+  col_weight.assign(partial.begin(), partial.begin() + cols);
+  for (size_t p = 1; p < parts; ++p)
+    for (size_t j = 0; j < cols; ++j)
+      col_weight[j] += partial[p * cols + j];
+
+  for (std::vector<double>* weight : {&row_weight, &col_weight}) {
+    const double mean = std::accumulate(weight->begin(), weight->end(), 0.0) / weight->size();
+    for (double& w : *weight)
+      w += mean > 0 ? mean : 1;
+  }
+}
+
+// Copies the picked rows and columns of a grid.
+template<typename Grid>
+PyObject* pick_grid(const Grid& g, const std::vector<size_t>& rows, const std::vector<size_t>& cols)
+{
+  std::vector<double> picked(rows.size() * cols.size());
+  parallel_for(rows.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+      for (size_t j = 0; j < cols.size(); ++j)
+        picked[i * cols.size() + j] = g(rows[i], cols[j]);
+  }, cols.size());
+  return get_2darray(std::move(picked), rows.size(), cols.size());
+}
+
+// Draws a rows x cols surface whose values are read through x(i, j), y(i, j)
+// and z(i, j), reduced as set_surface_lod() asks for. full(rstride, cstride)
+// draws the whole grid.
+template<typename Grid, typename Full>
+void plot_surface(const Grid& x, const Grid& y, const Grid& z, size_t rows, size_t cols,
+                  const Full& full, const Keywords& keywords,
+                  const long fig_number)
+{
+  const SurfaceLOD mode = surface_lod_mode();
+  // strides or counts given by the caller take precedence
+  const bool explicit_detail = keywords.count("rstride") || keywords.count("cstride") ||
+                               keywords.count("rcount") || keywords.count("ccount");
+  if (mode == SurfaceLOD::None || explicit_detail || rows < 3 || cols < 3) {
+    full(1, 1);
+    return;
+  }
+
+  size_t polygons = surface_max_polygons();
+  if (polygons == 0) {
+    // about one cell per 6 x 6 pixels
+    double width, height;
+    figure_pixel_size(fig_number, width, height);
+    polygons = std::max<size_t>(4, static_cast<size_t>(width * height / 36));
+  }
+  const double shrink = std::sqrt(double(rows - 1) * (cols - 1) / polygons);
+  if (shrink <= 1) {
+    full(1, 1);
+    return;
+  }
+  const size_t out_rows = std::max<size_t>(2, static_cast<size_t>(std::ceil((rows - 1) / shrink)) + 1);
+  const size_t out_cols = std::max<size_t>(2, static_cast<size_t>(std::ceil((cols - 1) / shrink)) + 1);
+
+  if (mode == SurfaceLOD::Stride) {
+    full(static_cast<long>(std::ceil((rows - 1.0) / (out_rows - 1))),
+         static_cast<long>(std::ceil((cols - 1.0) / (out_cols - 1))));
+    return;
+  }
+
+  std::vector<double> row_weight, col_weight;
+  if (mode == SurfaceLOD::Adaptive) {
+    surface_curvature(z, rows, cols, row_weight, col_weight);
+  } else {
+    row_weight.assign(rows, 1.0);
+    col_weight.assign(cols, 1.0);
+  }
+  const std::vector<size_t> picked_rows = pick_lines(rows, out_rows, row_weight);
+  const std::vector<size_t> picked_cols = pick_lines(cols, out_cols, col_weight);
+
+  PyObject* xarray = pick_grid(x, picked_rows, picked_cols);
+  PyObject* yarray = pick_grid(y, picked_rows, picked_cols);
+  PyObject* zarray = pick_grid(z, picked_rows, picked_cols);
+  plot_surface(xarray, yarray, zarray, keywords, fig_number);
+}
+
+} // namespace detail
+
+/// Lets plot_surface() draw grids with more cells than the figure can show
+/// with fewer polygons. Stride has matplotlib skip rows and columns, Resample
+/// picks evenly spaced rows and columns in C++ and hands over only those,
+/// and Adaptive picks more of them where the surface bends strongly. The
+/// budget is about one polygon per 6 x 6 pixels of the figure unless
+/// max_polygons is given. Explicit rstride, cstride, rcount or ccount
+/// keywords turn this off for the call.
+inline void set_surface_lod(SurfaceLOD mode, size_t max_polygons = 0)
+{
+  detail::surface_lod_mode() = mode;
+  detail::surface_max_polygons() = max_polygons;
+}
+
+template <typename Numeric>
+void plot_surface(const std::vector<::std::vector<Numeric>> &x,
+                  const std::vector<::std::vector<Numeric>> &y,
+                  const std::vector<::std::vector<Numeric>> &z,
+                  const Keywords& keywords =
+                      Keywords(),
+                  const long fig_number=0)
+{
+  detail::_interpreter::get();
+
+  assert(x.size() == y.size());
+  assert(y.size() == z.size());
+
+  auto full = [&](long rstride, long cstride) {
+    // using numpy arrays
+    detail::plot_surface(detail::get_2darray(x), detail::get_2darray(y),
+                         detail::get_2darray(z), keywords, fig_number, rstride, cstride);
+  };
+  if (z.empty()) {
+    full(1, 1);
+    return;
+  }
+  auto at = [](const std::vector<::std::vector<Numeric>> &grid) {
+    return [&grid](size_t i, size_t j) { return static_cast<double>(grid[i][j]); };
+  };
+  detail::plot_surface(at(x), at(y), at(z), z.size(), z[0].size(), full, keywords, fig_number);
+}
+
+/// Same as above for x, y and z stored as row-major rows x cols grids,
+/// whose rows start row_pitch bytes apart (0 if they are packed). The grids
+/// are handed to matplotlib without copying them, unless set_surface_lod()
+/// picks some of their rows and columns.
+template <typename Numeric>
+void plot_surface(const Numeric *x, const Numeric *y, const Numeric *z,
+                  size_t rows, size_t cols,
+                  const Keywords& keywords =
+                      Keywords(),
+                  const long fig_number=0,
+                  std::ptrdiff_t row_pitch=0)
+{
+  detail::_interpreter::get();
+
+  if (row_pitch == 0)
+    row_pitch = cols * sizeof(Numeric);
+
+  auto full = [&](long rstride, long cstride) {
+    detail::plot_surface(detail::get_2darray(x, rows, cols, row_pitch),
+                         detail::get_2darray(y, rows, cols, row_pitch),
+                         detail::get_2darray(z, rows, cols, row_pitch),
+                         keywords, fig_number, rstride, cstride);
+  };
+  auto at = [row_pitch](const Numeric* grid) {
+    return [grid, row_pitch](size_t i, size_t j) {
+      return static_cast<double>(reinterpret_cast<const Numeric*>(
+          reinterpret_cast<const char*>(grid) + i * row_pitch)[j]);
+    };
+  };
+  detail::plot_surface(at(x), at(y), at(z), rows, cols, full, keywords, fig_number);
+}
+
+namespace detail {
+
+inline void contour(PyObject *xarray, PyObject *yarray, PyObject *zarray,
+                    const Keywords& keywords)
+{
+  // Build up the kw args.
+  PyObject *kwargs = PyDict_New();
+
+  PyObject *python_colormap_coolwarm = PyString_FromString("coolwarm");
+  PyDict_SetItemString(kwargs, "cmap", python_colormap_coolwarm);
+  Py_DECREF(python_colormap_coolwarm);
+
+  keywords.add_to(kwargs);
+
+  PyObject *res = detail::call(detail::_interpreter::get().s_python_function_contour,
+                               {xarray, yarray, zarray}, kwargs);
+  Py_DECREF(kwargs);
+  if (!res)
+    throw std::runtime_error("failed contour");
+  Py_DECREF(res);
+}
+
+} // namespace detail
+
+template <typename Numeric>
+void contour(const std::vector<::std::vector<Numeric>> &x,
+             const std::vector<::std::vector<Numeric>> &y,
+             const std::vector<::std::vector<Numeric>> &z,
+             const Keywords& keywords = {})
+{
+  detail::_interpreter::get();
+
+  // using numpy arrays
+  detail::contour(detail::get_2darray(x), detail::get_2darray(y),
+                  detail::get_2darray(z), keywords);
+}
+
+template <typename Numeric>
+void contour(const Numeric *x, const Numeric *y, const Numeric *z,
+             size_t rows, size_t cols,
+             const Keywords& keywords = {},
+             std::ptrdiff_t row_pitch = 0)
+{
+  detail::_interpreter::get();
+
+  detail::contour(detail::get_2darray(x, rows, cols, row_pitch),
+                  detail::get_2darray(y, rows, cols, row_pitch),
+                  detail::get_2darray(z, rows, cols, row_pitch), keywords);
+}
+
+namespace detail {
+
+inline void spy(PyObject *xarray, const double markersize,
+                const Keywords& keywords)
+{
+  PyObject *kwargs = PyDict_New();
+  if (markersize != -1) {
+    PyDict_SetItemString(kwargs, "markersize", PyFloat_FromDouble(markersize));
+  }
+  keywords.add_to(kwargs);
+
+  PyObject *res = detail::call(
+      detail::_interpreter::get().s_python_function_spy, {xarray}, kwargs);
+
+  Py_DECREF(kwargs);
+  if (res) Py_DECREF(res);
+}
+
+} // namespace detail
+
+template <typename Numeric>
+void spy(const std::vector<::std::vector<Numeric>> &x,
+         const double markersize = -1,  // -1 for default matplotlib size
+         const Keywords& keywords = {})
+{
+  detail::_interpreter::get();
+
+  detail::spy(detail::get_2darray(x), markersize, keywords);
+}
+
+template <typename Numeric>
+void spy(const Numeric *x, size_t rows, size_t cols,
+         const double markersize = -1,  // -1 for default matplotlib size
+         const Keywords& keywords = {},
+         std::ptrdiff_t row_pitch = 0)
+{
+  detail::_interpreter::get();
+
+  detail::spy(detail::get_2darray(x, rows, cols, row_pitch), markersize, keywords);
+}
+
+template <typename Numeric>
+void plot3(const std::vector<Numeric> &x,
+                  const std::vector<Numeric> &y,
+                  const std::vector<Numeric> &z,
+                  const Keywords& keywords =
+                      Keywords(),
+                  const long fig_number=0)
+{
+  detail::_interpreter::get();
+
+  assert(x.size() == y.size());
+  assert(y.size() == z.size());
+
+  PyObject *fig = detail::find_figure(fig_number);
+  PyObject *axis = detail::axes3d(fig);
+  Py_DECREF(fig);
+
+  PyObject *res = detail::call(detail::axes_method(axis, "plot"),
+                               {detail::get_array(x), detail::get_array(y), detail::get_array(z)},
+                               keywords.empty() ? NULL : keywords.dict());
+  Py_DECREF(axis);
+  if (!res) throw std::runtime_error("Failed 3D line plot");
+  Py_DECREF(res);
+}
+
+template<typename Numeric>
+bool stem(const std::vector<Numeric> &x, const std::vector<Numeric> &y, const Keywords& keywords)
+{
+    assert(x.size() == y.size());
+
+    detail::_interpreter::get();
+
+    // using numpy arrays
+    return detail::plot(detail::_interpreter::get().s_python_function_stem,
+                        detail::get_array(x), detail::get_array(y), keywords);
+}
+
+template<typename NumericX, typename NumericY>
+bool stem(const NumericX* x, const NumericY* y, size_t n, const Keywords& keywords,
+          std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
+
+    return detail::plot(detail::_interpreter::get().s_python_function_stem,
+                        detail::get_array(x, n, xstride), detail::get_array(y, n, ystride), keywords);
+}
+
+template< typename Numeric >
+bool fill(const std::vector<Numeric>& x, const std::vector<Numeric>& y, const Keywords& keywords)
+{
+    assert(x.size() == y.size());
+
+    detail::_interpreter::get();
+
+    // using numpy arrays
+    PyObject *xarray, *yarray;
+    detail::get_path_arrays(x.data(), sizeof(Numeric), y.data(), sizeof(Numeric), x.size(), xarray, yarray);
+    return detail::plot(detail::_interpreter::get().s_python_function_fill, xarray, yarray, keywords);
+}
+
+/// Fills many polygons in one call, e.g. all outlines of a map. With
+/// set_simplification() they are simplified in parallel.
+template<typename Numeric>
+bool fill(const std::vector<std::vector<Numeric>>& x, const std::vector<std::vector<Numeric>>& y,
+          const Keywords& keywords)
+{
+    assert(x.size() == y.size());
+
+    detail::_interpreter::get();
+
+    typedef detail::strided_path<Numeric, Numeric> Path;
+    std::vector<Path> paths;
+    for (size_t k = 0; k < x.size(); ++k) {
+        assert(x[k].size() == y[k].size());
+        paths.push_back(Path{{x[k].data(), sizeof(Numeric)}, {y[k].data(), sizeof(Numeric)}, x[k].size()});
+    }
+    std::vector<std::vector<size_t>> kept;
+    const bool simplified = detail::simplify_paths(paths, kept);
+
+    std::vector<PyObject*> args(2 * paths.size());
+    for (size_t k = 0; k < paths.size(); ++k) {
+        if (simplified) {
+            detail::get_kept_arrays(paths[k], kept[k], args[2 * k], args[2 * k + 1]);
+        } else {
+            args[2 * k] = detail::get_array(x[k]);
+            args[2 * k + 1] = detail::get_array(y[k]);
+        }
+    }
+
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_fill, args.data(), args.size(),
+                                 keywords.empty() ? NULL : keywords.dict());
+    if (res) Py_DECREF(res);
+
+    return res;
+}
+
+template<typename NumericX, typename NumericY>
+bool fill(const NumericX* x, const NumericY* y, size_t n, const Keywords& keywords,
+          std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
+
+    PyObject *xarray, *yarray;
+    detail::get_path_arrays(x, xstride, y, ystride, n, xarray, yarray);
+    return detail::plot(detail::_interpreter::get().s_python_function_fill, xarray, yarray, keywords);
+}
+
+template< typename Numeric >
+bool fill_between(const std::vector<Numeric>& x, const std::vector<Numeric>& y1, const std::vector<Numeric>& y2, const Keywords& keywords)
+{
+    assert(x.size() == y1.size());
+    assert(x.size() == y2.size());
+
+    detail::_interpreter::get();
+
+    // using numpy arrays
+    return detail::fill_between(detail::get_array(x), detail::get_array(y1), detail::get_array(y2), keywords);
+}
+
+template<typename NumericX, typename NumericY>
+bool fill_between(const NumericX* x, const NumericY* y1, const NumericY* y2, size_t n, const Keywords& keywords,
+                  std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
+
+    return detail::fill_between(detail::get_array(x, n, xstride), detail::get_array(y1, n, ystride),
+                                detail::get_array(y2, n, ystride), keywords);
+}
 
+template <typename Numeric>
+bool arrow(Numeric x, Numeric y, Numeric end_x, Numeric end_y, const std::string& fc = "r",
+           const std::string ec = "k", Numeric head_length = 0.25, Numeric head_width = 0.1625) {
     PyObject* kwargs = PyDict_New();
     PyDict_SetItemString(kwargs, "fc", PyString_FromString(fc.c_str()));
     PyDict_SetItemString(kwargs, "ec", PyString_FromString(ec.c_str()));
     PyDict_SetItemString(kwargs, "head_width", PyFloat_FromDouble(head_width));
     PyDict_SetItemString(kwargs, "head_length", PyFloat_FromDouble(head_length));
 
-    PyObject* plot_args = PyTuple_New(4);
-    PyTuple_SetItem(plot_args, 0, obj_x);
-    PyTuple_SetItem(plot_args, 1, obj_y);
-    PyTuple_SetItem(plot_args, 2, obj_end_x);
-    PyTuple_SetItem(plot_args, 3, obj_end_y);
+    PyObject* res =
+            detail::call(detail::_interpreter::get().s_python_function_arrow,
+                         {PyFloat_FromDouble(x), PyFloat_FromDouble(y),
+                          PyFloat_FromDouble(end_x), PyFloat_FromDouble(end_y)}, kwargs);
+
+    Py_DECREF(kwargs);
+    if (res)
+        Py_DECREF(res);
+
+    return res;
+}
+
+template< typename Numeric>
+bool hist(const std::vector<Numeric>& y, long bins=10,std::string color="b",
+          double alpha=1.0, bool cumulative=false)
+{
+    detail::_interpreter::get();
+
+    return detail::hist(detail::auto_histogram(y.data(), y.size(), bins, sizeof(Numeric)),
+                        color, alpha, cumulative, "");
+}
+
+template<typename Numeric>
+bool hist(const Numeric* y, size_t n, long bins=10, std::string color="b",
+          double alpha=1.0, bool cumulative=false, std::ptrdiff_t ystride = sizeof(Numeric))
+{
+    detail::_interpreter::get();
+
+    return detail::hist(detail::auto_histogram(y, n, bins, ystride), color, alpha, cumulative, "");
+}
+
+/// Draws bins that were counted beforehand, see Histogram.
+inline bool hist(const Histogram& h, std::string color="b", double alpha=1.0, bool cumulative=false)
+{
+    detail::_interpreter::get();
+
+    return detail::hist(h, color, alpha, cumulative, "");
+}
+
+namespace detail {
+
+inline void imshow(PyObject* image, const Keywords& keywords, PyObject** out)
+{
+    PyObject* fn = detail::_interpreter::get().s_python_function_imshow;
+    PyObject* kwargs = keywords.empty() ? NULL : keywords.dict();
+    PyObject *res = out ? call_now(fn, {image}, kwargs) : call(fn, {image}, kwargs);
+    if (!res)
+        throw std::runtime_error("Call to imshow() failed");
+    if (out)
+        *out = res;
+    else
+        Py_DECREF(res);
+}
+
+} // namespace detail
+
+#ifndef WITHOUT_NUMPY
+namespace detail {
+
+inline void imshow(void *ptr, const NPY_TYPES type, const int rows, const int columns, const int colors, const Keywords& keywords, PyObject** out)
+{
+    assert(type == NPY_UINT8 || type == NPY_FLOAT);
+    assert(colors == 1 || colors == 3 || colors == 4);
+
+    detail::_interpreter::get();
+
+    npy_intp dims[3] = { rows, columns, colors };
+    imshow(PyArray_SimpleNewFromData(colors == 1 ? 2 : 3, dims, type, ptr), keywords, out);
+}
+
+} // namespace detail
+
+inline void imshow(const unsigned char *ptr, const int rows, const int columns, const int colors, const Keywords& keywords = {}, PyObject** out = nullptr)
+{
+    detail::imshow((void *) ptr, NPY_UINT8, rows, columns, colors, keywords, out);
+}
+
+inline void imshow(const float *ptr, const int rows, const int columns, const int colors, const Keywords& keywords = {}, PyObject** out = nullptr)
+{
+    detail::imshow((void *) ptr, NPY_FLOAT, rows, columns, colors, keywords, out);
+}
+
+#ifdef WITH_OPENCV
+void imshow(const cv::Mat &image, const Keywords& keywords = {})
+{
+    // Convert underlying type of matrix, if needed
+    cv::Mat image2;
+    NPY_TYPES npy_type = NPY_UINT8;
+    switch (image.type() & CV_MAT_DEPTH_MASK) {
+    case CV_8U:
+        image2 = image;
+        break;
+    case CV_32F:
+        image2 = image;
+        npy_type = NPY_FLOAT;
+        break;
+    default:
+        image.convertTo(image2, CV_MAKETYPE(CV_8U, image.channels()));
+    }
+
+    // If color image, convert from BGR to RGB
+    switch (image2.channels()) {
+    case 3:
+        cv::cvtColor(image2, image2, CV_BGR2RGB);
+        break;
+    case 4:
+        cv::cvtColor(image2, image2, CV_BGRA2RGBA);
+    }
+
+    detail::imshow(image2.data, npy_type, image2.rows, image2.cols, image2.channels(), keywords);
+}
+#endif // WITH_OPENCV
+#endif // WITHOUT_NUMPY
+
+namespace detail {
+
+// numpy is loaded on first use, since only the memory mapped arrays below
+// need its python module
+inline PyObject* numpy_module()
+{
+    static PyObject* numpymod = nullptr;
+    if (!numpymod) {
+        detail::_interpreter::get();
+
+        PyObject* numpyname = PyString_FromString("numpy");
+        if (!numpyname) { throw std::runtime_error("couldnt create string"); }
+
+        numpymod = PyImport_Import(numpyname);
+        Py_DECREF(numpyname);
+        if (!numpymod) { throw std::runtime_error("Error loading module numpy!"); }
+    }
+    return numpymod;
+}
+
+} // namespace detail
+
+// A read-only numpy array over a memory mapped file. Nothing is read up
+// front: the OS pages in what matplotlib actually touches, so files much
+// larger than the available memory can be plotted without copying them.
+class MappedArray
+{
+public:
+    // `count` values (all remaining ones for -1) of the numpy type `dtype`,
+    // e.g. "<f4" or "int16", starting `offset` bytes into a raw binary file
+    explicit MappedArray(const std::string& path, const std::string& dtype,
+                         size_t offset = 0, long count = -1)
+    {
+        PyObject* memmap = PyObject_GetAttrString(detail::numpy_module(), "memmap");
+        if (!memmap) throw std::runtime_error("Couldn't find numpy.memmap");
+
+        PyObject* args = Py_BuildValue("(s)", path.c_str());
+        PyObject* kwargs = PyDict_New();
+        PyDict_SetItemString(kwargs, "dtype", PyString_FromString(dtype.c_str()));
+        PyDict_SetItemString(kwargs, "mode", PyString_FromString("r"));
+        PyDict_SetItemString(kwargs, "offset", PyLong_FromSize_t(offset));
+        if (count >= 0)
+            PyDict_SetItemString(kwargs, "shape", Py_BuildValue("(l)", count));
+
+        array = PyObject_Call(memmap, args, kwargs);
+        Py_DECREF(memmap);
+        Py_DECREF(args);
+        Py_DECREF(kwargs);
+        if (!array) throw std::runtime_error("Couldn't map " + path);
+    }
+
+    // an .npy file, which brings its own type and shape
+    static MappedArray npy(const std::string& path)
+    {
+        PyObject* res = PyObject_CallMethod(detail::numpy_module(), const_cast<char*>("load"),
+                                            const_cast<char*>("(ss)"), path.c_str(), "r");
+        if (!res) throw std::runtime_error("Couldn't map " + path);
+        return MappedArray(res);
+    }
+
+    MappedArray(const MappedArray& other) : array(other.array) { Py_INCREF(array); }
+
+    MappedArray& operator=(const MappedArray& other)
+    {
+        Py_INCREF(other.array);
+        Py_DECREF(array);
+        array = other.array;
+        return *this;
+    }
+
+    ~MappedArray()
+    {
+        // a MappedArray may outlive the interpreter
+        if (Py_IsInitialized()) Py_DECREF(array);
+    }
+
+    // the same data viewed as a row-major rows x cols grid, e.g. for imshow()
+    MappedArray reshape(long rows, long cols) const
+    {
+        PyObject* res = PyObject_CallMethod(array, const_cast<char*>("reshape"), const_cast<char*>("(ll)"), rows, cols);
+        if (!res) throw std::runtime_error("Call to reshape() failed.");
+        return MappedArray(res);
+    }
+
+    // the number of values, across all dimensions
+    size_t size() const
+    {
+        PyObject* res = PyObject_GetAttrString(array, "size");
+        if (!res) throw std::runtime_error("Couldn't get the size of the array.");
+        const size_t n = PyLong_AsSize_t(res);
+        Py_DECREF(res);
+        return n;
+    }
+
+    // a new reference to the underlying numpy array
+    PyObject* get() const
+    {
+        Py_INCREF(array);
+        return array;
+    }
+
+private:
+    explicit MappedArray(PyObject* array) : array(array) {}
+
+    PyObject* array;
+};
+
+inline bool plot(const MappedArray& x, const MappedArray& y, const std::string& format = "")
+{
+    return detail::plot(detail::_interpreter::get().s_python_function_plot, x.get(), y.get(), format, NULL);
+}
+
+inline bool plot(const MappedArray& y, const std::string& format = "")
+{
+    return detail::plot(detail::_interpreter::get().s_python_function_plot, NULL, y.get(), format, NULL);
+}
+
+inline bool scatter(const MappedArray& x, const MappedArray& y,
+                    const double s=1.0, // The marker size in points**2
+                    const Keywords& keywords = {})
+{
+    return detail::scatter(x.get(), y.get(), NULL, s, keywords);
+}
+
+inline void imshow(const MappedArray& image, const Keywords& keywords = {}, PyObject** out = nullptr)
+{
+    detail::imshow(image.get(), keywords, out);
+}
+
+/// An image together with copies of it that are halved again and again (mip
+/// levels), built once in parallel by averaging 2 x 2 blocks. imshow() hands
+/// matplotlib only the coarsest level that still has as many pixels as the
+/// current axes, cropped to the x and y limits if they were set, so even huge
+/// images are redrawn quickly. Pixel is unsigned char or float, with colors
+/// values per pixel like for imshow(). The full resolution image is not
+/// copied, so it has to stay valid while the pyramid is used.
+template<typename Pixel>
+class ImagePyramid
+{
+public:
+    ImagePyramid(const Pixel* data, size_t rows, size_t cols, size_t colors = 1)
+        : source_(data), colors_(colors), min_(NAN), max_(NAN)
+    {
+        static_assert(std::is_same<Pixel, unsigned char>::value || std::is_same<Pixel, float>::value,
+                      "ImagePyramid holds unsigned char or float pixels");
+        if (colors != 1 && colors != 3 && colors != 4)
+            throw std::runtime_error("ImagePyramid needs 1, 3 or 4 colors per pixel.");
+
+        rows_.push_back(rows);
+        cols_.push_back(cols);
+        while (rows_.back() > min_size || cols_.back() > min_size)
+            halve();
+
+        if (colors_ == 1)
+            find_range();
+    }
+
+    size_t levels() const { return rows_.size(); }
+    size_t rows(size_t level = 0) const { return rows_[level]; }
+    size_t cols(size_t level = 0) const { return cols_[level]; }
+    size_t colors() const { return colors_; }
+
+    const Pixel* data(size_t level = 0) const
+    {
+        return level == 0 ? source_ : mips_[level - 1].data();
+    }
+
+    // The smallest and largest value of a single channel image, which keep
+    // the colors the same on every level and crop.
+    double min() const { return min_; }
+    double max() const { return max_; }
+
+private:
+    // levels stop once they fit into min_size x min_size
+    static const size_t min_size = 64;
+
+    void halve()
+    {
+        const Pixel* src = data(levels() - 1);
+        const size_t rows = rows_.back(), cols = cols_.back();
+        const size_t half_rows = (rows + 1) / 2, half_cols = (cols + 1) / 2;
+        const size_t colors = colors_;
+
+        std::vector<Pixel> dst(half_rows * half_cols * colors);
+        detail::parallel_for(half_rows, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const size_t r0 = 2 * i, r1 = std::min(2 * i + 1, rows - 1);
+                for (size_t j = 0; j < half_cols; ++j) {
+                    const size_t c0 = 2 * j, c1 = std::min(2 * j + 1, cols - 1);
+                    const double count = (r1 - r0 + 1) * (c1 - c0 + 1);
+                    for (size_t k = 0; k < colors; ++k) {
+                        double sum = src[(r0 * cols + c0) * colors + k];
+                        if (c1 != c0) sum += src[(r0 * cols + c1) * colors + k];
+                        if (r1 != r0) sum += src[(r1 * cols + c0) * colors + k];
+                        if (r1 != r0 && c1 != c0) sum += src[(r1 * cols + c1) * colors + k];
+                        dst[(i * half_cols + j) * colors + k] = average(sum, count);
+                    }
+                }
+            }
+        }, 4 * half_cols * colors);
+
+        mips_.push_back(std::move(dst));
+        rows_.push_back(half_rows);
+        cols_.push_back(half_cols);
+    }
+
+    static Pixel average(double sum, double count)
+    {
+        return std::is_integral<Pixel>::value ? static_cast<Pixel>(sum / count + 0.5)
+                                              : static_cast<Pixel>(sum / count);
+    }
+
+    // NaN pixels are left out
+    void find_range()
+    {
+        const size_t n = rows_[0] * cols_[0];
+        const size_t parts = std::max<size_t>(1, std::min(detail::thread_count(), n / detail::parallel_min_chunk));
+        std::vector<double> lo(parts, INFINITY), hi(parts, -INFINITY);
+        detail::parallel_for(parts, [&](size_t begin, size_t end) {
+            for (size_t p = begin; p < end; ++p)
+                for (size_t i = n * p / parts; i < n * (p + 1) / parts; ++i) {
+                    const double v = source_[i];
+                    if (v < lo[p]) lo[p] = v;
+                    if (v > hi[p]) hi[p] = v;
+                }
+        }, n / parts);
+        const double lowest = *std::min_element(lo.begin(), lo.end());
+        const double highest = *std::max_element(hi.begin(), hi.end());
+        if (lowest <= highest) {
+            min_ = lowest;
+            max_ = highest;
+        }
+    }
+
+    const Pixel* source_;
+    size_t colors_;
+    double min_, max_;
+    std::vector<size_t> rows_, cols_;
+    std::vector<std::vector<Pixel>> mips_;
+};
+
+namespace detail {
+
+// The half-open range of pixels [first, last) out of n that the axis limits
+// lo..hi show, where pixel i is centered at i like in imshow(), or all of
+// them while that axis autoscales.
+inline void visible_pixels(char axis, size_t n, size_t& first, size_t& last)
+{
+    double lo, hi;
+    first = 0;
+    last = n;
+    if (!fixed_lim(axis, lo, hi)) return;
+    first = static_cast<size_t>(std::min<double>(n, std::max(0.0, std::floor(lo + 0.5))));
+    last = static_cast<size_t>(std::min<double>(n, std::max(0.0, std::ceil(hi + 0.5))));
+    if (last <= first) { // nothing visible, still show a pixel to keep the limits
+        first = std::min(first, n - 1);
+        last = first + 1;
+    }
+}
+
+} // namespace detail
+
+/// Shows the part of the pyramid's image that is visible in the current axes
+/// at about the resolution of the screen. The image is placed exactly where
+/// imshow() of the full image would put it, so call this again after
+/// changing the limits, e.g. by xlim() and ylim(), to get the detail back.
+template<typename Pixel>
+void imshow(const ImagePyramid<Pixel>& image, const Keywords& keywords = {}, PyObject** out = nullptr)
+{
+    detail::_interpreter::get();
+
+    size_t r0, r1, c0, c1;
+    detail::visible_pixels('y', image.rows(), r0, r1);
+    detail::visible_pixels('x', image.cols(), c0, c1);
+
+    // the coarsest level with at least one pixel per pixel of the axes
+    double width, height;
+    detail::axes_pixel_size(width, height);
+    const double scale = std::min((c1 - c0) / std::max(width, 1.0), (r1 - r0) / std::max(height, 1.0));
+    size_t level = 0;
+    while (level + 1 < image.levels() && std::ldexp(1.0, static_cast<int>(level) + 1) <= scale)
+        ++level;
+
+    // the crop on that level, one pixel wider on every side
+    const size_t shift = level;
+    const size_t rows = image.rows(level), cols = image.cols(level), colors = image.colors();
+    const size_t lr0 = (r0 >> shift) > 0 ? (r0 >> shift) - 1 : 0;
+    const size_t lc0 = (c0 >> shift) > 0 ? (c0 >> shift) - 1 : 0;
+    const size_t lr1 = std::min(rows, ((r1 - 1) >> shift) + 2);
+    const size_t lc1 = std::min(cols, ((c1 - 1) >> shift) + 2);
+    const size_t crop_rows = lr1 - lr0, crop_cols = lc1 - lc0;
+
+    // unsigned char colors have to be scaled to [0, 1] once they are doubles
+    const double factor = colors > 1 && std::is_integral<Pixel>::value ? 1.0 / 255 : 1.0;
+    const Pixel* src = image.data(level);
+    std::vector<double> crop(crop_rows * crop_cols * colors);
+    detail::parallel_for(crop_rows, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Pixel* row = src + ((lr0 + i) * cols + lc0) * colors;
+            for (size_t j = 0; j < crop_cols * colors; ++j)
+                crop[i * crop_cols * colors + j] = row[j] * factor;
+        }
+    }, crop_cols * colors);
+
+    PyObject* array = detail::get_2darray(std::move(crop), crop_rows, crop_cols * colors);
+    if (colors > 1) {
+        PyObject* shaped = PyObject_CallMethod(array, const_cast<char*>("reshape"), const_cast<char*>("(nnn)"),
+                                               static_cast<Py_ssize_t>(crop_rows), static_cast<Py_ssize_t>(crop_cols),
+                                               static_cast<Py_ssize_t>(colors));
+        Py_DECREF(array);
+        if (!shaped) throw std::runtime_error("Call to reshape() failed.");
+        array = shaped;
+    }
+
+    // where the crop lies in the pixel coordinates of the full image
+    const double left = std::ldexp(double(lc0), shift) - 0.5;
+    const double right = std::min<double>(image.cols(), std::ldexp(double(lc1), shift)) - 0.5;
+    const double top = std::ldexp(double(lr0), shift) - 0.5;
+    const double bottom = std::min<double>(image.rows(), std::ldexp(double(lr1), shift)) - 0.5;
+    Keywords::const_iterator origin = keywords.find("origin");
+    const bool lower = origin != keywords.end() && origin->second.str() == "lower";
+
+    PyObject* kwargs = PyDict_New();
+    PyDict_SetItemString(kwargs, "extent", lower ? Py_BuildValue("(dddd)", left, right, top, bottom)
+                                                 : Py_BuildValue("(dddd)", left, right, bottom, top));
+    if (colors == 1 && !keywords.count("norm") && image.min() <= image.max()) {
+        if (!keywords.count("vmin")) PyDict_SetItemString(kwargs, "vmin", PyFloat_FromDouble(image.min()));
+        if (!keywords.count("vmax")) PyDict_SetItemString(kwargs, "vmax", PyFloat_FromDouble(image.max()));
+    }
+    keywords.add_to(kwargs);
+
+    PyObject* fn = detail::_interpreter::get().s_python_function_imshow;
+    PyObject *res = out ? detail::call_now(fn, {array}, kwargs) : detail::call(fn, {array}, kwargs);
+    Py_DECREF(kwargs);
+    if (!res)
+        throw std::runtime_error("Call to imshow() failed");
+    if (out)
+        *out = res;
+    else
+        Py_DECREF(res);
+}
+
+/// How scatter_density() combines the values of the points that fall into
+/// the same pixel.
+enum class Aggregate { Count, Mean, Max };
+
+/// How scatter_density() maps the combined values to colors. EqHist ranks
+/// the occupied pixels by value and spreads the colormap evenly over them.
+enum class DensityNorm { Linear, Log, EqHist };
+
+namespace detail {
+
+inline PyObject* colors_module()
+{
+    static PyObject* colorsmod = nullptr;
+    if (!colorsmod) {
+        detail::_interpreter::get();
+
+        PyObject* colorsname = PyString_FromString("matplotlib.colors");
+        if (!colorsname) { throw std::runtime_error("couldnt create string"); }
+
+        colorsmod = PyImport_Import(colorsname);
+        Py_DECREF(colorsname);
+        if (!colorsmod) { throw std::runtime_error("Error loading module matplotlib.colors!"); }
+    }
+    return colorsmod;
+}
+
+// Combines the values of n points per cell, where cell_of(i) is the cell of
+// point i, or `cells` if it falls into none. Every thread fills cells of its
+// own, which are merged in the end. Cells no point fell into are NaN.
+template<typename CellOf, typename Values>
+std::vector<double> aggregate_cells(size_t n, size_t cells, const CellOf& cell_of,
+                                    const Values& v, Aggregate how)
+{
+    const size_t parts = std::max<size_t>(1, std::min(thread_count(), n / parallel_min_chunk));
+    const bool mean = how == Aggregate::Mean;
+
+    // per part sums or maxima, which counting alone doesn't need, and counts
+    std::vector<double> acc(how == Aggregate::Count ? 0 : parts * cells,
+                            how == Aggregate::Max ? -INFINITY : 0.0);
+    std::vector<double> counts(how == Aggregate::Max ? 0 : parts * cells, 0.0);
+
+    parallel_for(parts, [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+            double* a = acc.empty() ? NULL : &acc[p * cells];
+            double* c = counts.empty() ? NULL : &counts[p * cells];
+            for (size_t i = n * p / parts; i < n * (p + 1) / parts; ++i) {
+                const size_t cell = cell_of(i);
+                if (cell >= cells) continue;
+                if (how == Aggregate::Max) {
+                    a[cell] = std::max(a[cell], v[i]);
+                } else {
+                    if (mean) a[cell] += v[i];
+                    c[cell] += 1;
+                }
+            }
+        }
+    }, n / parts);
+
+    std::vector<double> grid(cells);
+    parallel_for(cells, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            double a = acc.empty() ? 0 : acc[k], c = counts.empty() ? 0 : counts[k];
+            for (size_t p = 1; p < parts; ++p) {
+                if (how == Aggregate::Max) {
+                    a = std::max(a, acc[p * cells + k]);
+                } else {
+                    if (mean) a += acc[p * cells + k];
+                    c += counts[p * cells + k];
+                }
+            }
+            if (how == Aggregate::Max)
+                grid[k] = a == -INFINITY ? NAN : a;
+            else if (c == 0)
+                grid[k] = NAN;
+            else
+                grid[k] = mean ? a / c : c;
+        }
+    }, parts);
+
+    return grid;
+}
+
+// Bins n points into a rows x cols grid spanning [x0, x1] x [y0, y1], with
+// row 0 at y0.
+template<typename NumericX, typename NumericY, typename NumericV>
+std::vector<double> density_grid(const strided<NumericX>& x, const strided<NumericY>& y,
+                                 const strided<NumericV>& v, size_t n, Aggregate how,
+                                 double x0, double x1, double y0, double y1, size_t rows, size_t cols)
+{
+    const double sx = cols / (x1 - x0), sy = rows / (y1 - y0);
+    return aggregate_cells(n, rows * cols, [&](size_t i) -> size_t {
+        const double px = (x[i] - x0) * sx, py = (y[i] - y0) * sy;
+        if (!(px >= 0 && py >= 0 && px <= cols && py <= rows)) return rows * cols; // NaN as well
+        return std::min(rows - 1, static_cast<size_t>(py)) * cols
+             + std::min(cols - 1, static_cast<size_t>(px));
+    }, v, how);
+}
+
+// Replaces every value by its rank among all finite ones, scaled to [0, 1].
+inline void equalize(std::vector<double>& grid)
+{
+    std::vector<double> sorted;
+    for (double g : grid)
+        if (std::isfinite(g)) sorted.push_back(g);
+    std::sort(sorted.begin(), sorted.end());
+
+    const double scale = sorted.size() > 1 ? 1.0 / (sorted.size() - 1) : 1.0;
+    for (double& g : grid) {
+        if (std::isfinite(g))
+            g = (std::lower_bound(sorted.begin(), sorted.end(), g) - sorted.begin()) * scale;
+    }
+}
+
+// The range of the points with finite coordinates, widened where it is
+// empty. Returns false if there are no such points.
+template<typename NumericX, typename NumericY>
+bool data_bounds(const strided<NumericX>& x, const strided<NumericY>& y, size_t n,
+                 double& x0, double& x1, double& y0, double& y1)
+{
+    x0 = y0 = INFINITY;
+    x1 = y1 = -INFINITY;
+    for (size_t i = 0; i < n; ++i) {
+        const double px = x[i], py = y[i];
+        if (!std::isfinite(px) || !std::isfinite(py)) continue;
+        x0 = std::min(x0, px); x1 = std::max(x1, px);
+        y0 = std::min(y0, py); y1 = std::max(y1, py);
+    }
+    if (!(x1 >= x0)) return false;
+    if (x1 == x0) { x0 -= 0.5; x1 += 0.5; }
+    if (y1 == y0) { y0 -= 0.5; y1 += 0.5; }
+    return true;
+}
+
+// Shows a grid built by density_grid() through imshow().
+inline bool show_grid(std::vector<double>&& grid, size_t rows, size_t cols,
+                      double x0, double x1, double y0, double y1, DensityNorm norm,
+                      const Keywords& keywords, PyObject** out)
+{
+    if (norm == DensityNorm::EqHist)
+        equalize(grid);
+
+    PyObject* kwargs = PyDict_New();
+    PyDict_SetItemString(kwargs, "extent", Py_BuildValue("(dddd)", x0, x1, y0, y1));
+    PyDict_SetItemString(kwargs, "origin", PyString_FromString("lower"));
+    PyDict_SetItemString(kwargs, "aspect", PyString_FromString("auto"));
+    PyDict_SetItemString(kwargs, "interpolation", PyString_FromString("nearest"));
+    if (norm == DensityNorm::Log) {
+        PyObject* lognorm = PyObject_CallMethod(colors_module(), const_cast<char*>("LogNorm"), NULL);
+        if (!lognorm) {
+            Py_DECREF(kwargs);
+            throw std::runtime_error("Call to LogNorm() failed.");
+        }
+        PyDict_SetItemString(kwargs, "norm", lognorm);
+        Py_DECREF(lognorm);
+    }
+    keywords.add_to(kwargs);
 
-    PyObject* res =
-            PyObject_Call(detail::_interpreter::get().s_python_function_arrow, plot_args, kwargs);
+    PyObject* fn = detail::_interpreter::get().s_python_function_imshow;
+    PyObject* array = get_2darray(std::move(grid), rows, cols);
+    PyObject* res = out ? call_now(fn, {array}, kwargs) : call(fn, {array}, kwargs);
 
-    Py_DECREF(plot_args);
     Py_DECREF(kwargs);
-    if (res)
+    if (res && out)
+        *out = res;
+    else if (res)
         Py_DECREF(res);
 
     return res;
 }
 
-template< typename Numeric>
-bool hist(const std::vector<Numeric>& y, long bins=10,std::string color="b",
-          double alpha=1.0, bool cumulative=false)
+template<typename NumericX, typename NumericY, typename NumericV>
+bool scatter_density(const NumericX* x, const NumericY* y, const NumericV* values, size_t n,
+                     Aggregate how, DensityNorm norm, const Keywords& keywords,
+                     PyObject** out)
 {
     detail::_interpreter::get();
 
-    PyObject* yarray = detail::get_array(y);
+    const strided<NumericX> xv = {x, sizeof(NumericX)};
+    const strided<NumericY> yv = {y, sizeof(NumericY)};
+    const strided<NumericV> vv = {values, sizeof(NumericV)};
 
-    PyObject* kwargs = PyDict_New();
-    PyDict_SetItemString(kwargs, "bins", PyLong_FromLong(bins));
-    PyDict_SetItemString(kwargs, "color", PyString_FromString(color.c_str()));
-    PyDict_SetItemString(kwargs, "alpha", PyFloat_FromDouble(alpha));
-    PyDict_SetItemString(kwargs, "cumulative", cumulative ? Py_True : Py_False);
+    double x0, x1, y0, y1;
+    if (!data_bounds(xv, yv, n, x0, x1, y0, y1)) return true; // nothing to draw
 
-    PyObject* plot_args = PyTuple_New(1);
+    // one cell per pixel of the current axes
+    double width, height;
+    axes_pixel_size(width, height);
+    const size_t cols = std::max<size_t>(1, static_cast<size_t>(std::ceil(width)));
+    const size_t rows = std::max<size_t>(1, static_cast<size_t>(std::ceil(height)));
 
-    PyTuple_SetItem(plot_args, 0, yarray);
+    return show_grid(density_grid(xv, yv, vv, n, how, x0, x1, y0, y1, rows, cols),
+                     rows, cols, x0, x1, y0, y1, norm, keywords, out);
+}
 
+template<typename NumericX, typename NumericY>
+bool hist2d(const NumericX* x, const NumericY* y, size_t n, std::ptrdiff_t xstride, std::ptrdiff_t ystride,
+            size_t xbins, size_t ybins, DensityNorm norm,
+            const Keywords& keywords, PyObject** out)
+{
+    detail::_interpreter::get();
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_hist, plot_args, kwargs);
+    const strided<NumericX> xv = {x, xstride};
+    const strided<NumericY> yv = {y, ystride};
+    const strided<double> none = {NULL, 0};
 
+    double x0, x1, y0, y1;
+    if (!data_bounds(xv, yv, n, x0, x1, y0, y1)) return true; // nothing to draw
 
-    Py_DECREF(plot_args);
-    Py_DECREF(kwargs);
-    if(res) Py_DECREF(res);
+    // unlike scatter_density(), empty bins count as zero like in matplotlib
+    std::vector<double> grid = density_grid(xv, yv, none, n, Aggregate::Count, x0, x1, y0, y1, ybins, xbins);
+    for (double& g : grid)
+        if (std::isnan(g)) g = 0;
 
-    return res;
+    return show_grid(std::move(grid), ybins, xbins, x0, x1, y0, y1, norm, keywords, out);
 }
 
-#ifndef WITHOUT_NUMPY
-namespace detail {
-
-inline void imshow(void *ptr, const NPY_TYPES type, const int rows, const int columns, const int colors, const std::map<std::string, std::string> &keywords, PyObject** out)
+inline PyObject* collections_module()
 {
-    assert(type == NPY_UINT8 || type == NPY_FLOAT);
-    assert(colors == 1 || colors == 3 || colors == 4);
+    static PyObject* collectionsmod = nullptr;
+    if (!collectionsmod) {
+        detail::_interpreter::get();
+
+        PyObject* collectionsname = PyString_FromString("matplotlib.collections");
+        if (!collectionsname) { throw std::runtime_error("couldnt create string"); }
+
+        collectionsmod = PyImport_Import(collectionsname);
+        Py_DECREF(collectionsname);
+        if (!collectionsmod) { throw std::runtime_error("Error loading module matplotlib.collections!"); }
+    }
+    return collectionsmod;
+}
 
+// Bins the points into the same hexagonal grid as matplotlib's hexbin(): the
+// centers of a (gridsize + 1) x (ny + 1) lattice and of a second one shifted
+// by half a cell, with every point going to the nearer center. The occupied
+// hexagons are drawn as a PolyCollection colored by their counts.
+template<typename NumericX, typename NumericY>
+bool hexbin(const NumericX* x, const NumericY* y, size_t n, std::ptrdiff_t xstride, std::ptrdiff_t ystride,
+            size_t gridsize, DensityNorm norm,
+            const Keywords& keywords, PyObject** out)
+{
     detail::_interpreter::get();
 
-    // construct args
-    npy_intp dims[3] = { rows, columns, colors };
-    PyObject *args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, PyArray_SimpleNewFromData(colors == 1 ? 2 : 3, dims, type, ptr));
+    const strided<NumericX> xv = {x, xstride};
+    const strided<NumericY> yv = {y, ystride};
+    const strided<double> none = {NULL, 0};
+
+    double x0, x1, y0, y1;
+    if (!data_bounds(xv, yv, n, x0, x1, y0, y1)) return true; // nothing to draw
+
+    const size_t nx = std::max<size_t>(1, gridsize);
+    const size_t ny = std::max<size_t>(1, static_cast<size_t>(nx / std::sqrt(3.0)));
+    const double sx = (x1 - x0) / nx, sy = (y1 - y0) / ny;
+    const size_t cells1 = (nx + 1) * (ny + 1), cells = cells1 + nx * ny;
+
+    std::vector<double> grid = aggregate_cells(n, cells, [&](size_t i) -> size_t {
+        const double ix = (xv[i] - x0) / sx, iy = (yv[i] - y0) / sy;
+        if (!(ix >= 0 && iy >= 0 && ix <= nx && iy <= ny)) return cells; // NaN as well
+        const double ix1 = std::floor(ix + 0.5), iy1 = std::floor(iy + 0.5);
+        const double ix2 = std::min<double>(nx - 1, std::floor(ix)), iy2 = std::min<double>(ny - 1, std::floor(iy));
+        const double d1 = (ix - ix1) * (ix - ix1) + 3 * (iy - iy1) * (iy - iy1);
+        const double d2 = (ix - ix2 - 0.5) * (ix - ix2 - 0.5) + 3 * (iy - iy2 - 0.5) * (iy - iy2 - 0.5);
+        if (d1 < d2)
+            return static_cast<size_t>(ix1) * (ny + 1) + static_cast<size_t>(iy1);
+        return cells1 + static_cast<size_t>(ix2) * ny + static_cast<size_t>(iy2);
+    }, none, Aggregate::Count);
+
+    // hexagon corners relative to the center, as in matplotlib
+    static const double corners[6][2] = {{.5, -.5}, {.5, .5}, {0., 1.}, {-.5, .5}, {-.5, -.5}, {0., -1.}};
+
+    std::vector<double> verts, counts;
+    for (size_t k = 0; k < cells; ++k) {
+        if (std::isnan(grid[k])) continue;
+        double cx, cy;
+        if (k < cells1) {
+            cx = x0 + sx * (k / (ny + 1));
+            cy = y0 + sy * (k % (ny + 1));
+        } else {
+            cx = x0 + sx * ((k - cells1) / ny + 0.5);
+            cy = y0 + sy * ((k - cells1) % ny + 0.5);
+        }
+        for (size_t c = 0; c < 6; ++c) {
+            verts.push_back(cx + corners[c][0] * sx);
+            verts.push_back(cy + corners[c][1] * sy / 3);
+        }
+        counts.push_back(grid[k]);
+    }
+    if (norm == DensityNorm::EqHist)
+        equalize(counts);
+
+    const size_t hexagons = counts.size();
+    PyObject* vertices = get_2darray(std::move(verts), hexagons * 6, 2);
+    PyObject* shaped = PyObject_CallMethod(vertices, const_cast<char*>("reshape"), const_cast<char*>("(nnn)"),
+                                           static_cast<Py_ssize_t>(hexagons), static_cast<Py_ssize_t>(6),
+                                           static_cast<Py_ssize_t>(2));
+    Py_DECREF(vertices);
+    if (!shaped) throw std::runtime_error("Call to reshape() failed.");
 
-    // construct keyword args
     PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-    {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
+    PyObject* carray = get_array(std::move(counts));
+    PyDict_SetItemString(kwargs, "array", carray);
+    Py_DECREF(carray);
+    PyObject* face = PyString_FromString("face");
+    PyDict_SetItemString(kwargs, "edgecolors", face);
+    Py_DECREF(face);
+    if (norm == DensityNorm::Log) {
+        PyObject* lognorm = PyObject_CallMethod(colors_module(), const_cast<char*>("LogNorm"), NULL);
+        if (!lognorm) {
+            Py_DECREF(shaped);
+            Py_DECREF(kwargs);
+            throw std::runtime_error("Call to LogNorm() failed.");
+        }
+        PyDict_SetItemString(kwargs, "norm", lognorm);
+        Py_DECREF(lognorm);
     }
+    keywords.add_to(kwargs);
 
-    PyObject *res = PyObject_Call(detail::_interpreter::get().s_python_function_imshow, args, kwargs);
+    PyObject* args = PyTuple_New(1);
+    PyTuple_SetItem(args, 0, shaped);
+    PyObject* polycollection = PyObject_GetAttrString(collections_module(), "PolyCollection");
+    PyObject* collection = polycollection ? PyObject_Call(polycollection, args, kwargs) : NULL;
+    Py_XDECREF(polycollection);
     Py_DECREF(args);
     Py_DECREF(kwargs);
-    if (!res)
-        throw std::runtime_error("Call to imshow() failed");
+    if (!collection) throw std::runtime_error("Couldn't create PolyCollection.");
+
+    PyObject* ax = gca();
+    Py_INCREF(collection);
+    PyObject* res = call(axes_method(ax, "add_collection"), {collection});
+    if (res) {
+        Py_DECREF(res);
+        res = call(axes_method(ax, "autoscale_view"), {});
+    }
+    Py_DECREF(ax);
+    if (!res) {
+        Py_DECREF(collection);
+        throw std::runtime_error("Couldn't add the hexagons to the axes.");
+    }
+    Py_DECREF(res);
+
     if (out)
-        *out = res;
+        *out = collection;
     else
-        Py_DECREF(res);
+        Py_DECREF(collection);
+    return true;
 }
 
 } // namespace detail
 
-inline void imshow(const unsigned char *ptr, const int rows, const int columns, const int colors, const std::map<std::string, std::string> &keywords = {}, PyObject** out = nullptr)
+/// Draws a scatter plot too large for one marker per point as an image:
+/// the points are counted per pixel of the current axes in C++, and the
+/// counts are shown through imshow() with the given norm. Pass `out` to
+/// get the image, e.g. for colorbar().
+template<typename NumericX, typename NumericY>
+bool scatter_density(const std::vector<NumericX>& x, const std::vector<NumericY>& y,
+                     DensityNorm norm = DensityNorm::Log,
+                     const Keywords& keywords = {},
+                     PyObject** out = nullptr)
 {
-    detail::imshow((void *) ptr, NPY_UINT8, rows, columns, colors, keywords, out);
+    assert(x.size() == y.size());
+
+    return detail::scatter_density(x.data(), y.data(), static_cast<const double*>(NULL), x.size(),
+                                   Aggregate::Count, norm, keywords, out);
 }
 
-inline void imshow(const float *ptr, const int rows, const int columns, const int colors, const std::map<std::string, std::string> &keywords = {}, PyObject** out = nullptr)
+/// Like above, but colors every pixel by the mean or maximum of the values
+/// of the points in it, the counterpart of scatter_colored().
+template<typename NumericX, typename NumericY, typename NumericV>
+bool scatter_density(const std::vector<NumericX>& x, const std::vector<NumericY>& y,
+                     const std::vector<NumericV>& values, Aggregate how = Aggregate::Mean,
+                     DensityNorm norm = DensityNorm::Linear,
+                     const Keywords& keywords = {},
+                     PyObject** out = nullptr)
 {
-    detail::imshow((void *) ptr, NPY_FLOAT, rows, columns, colors, keywords, out);
+    assert(x.size() == y.size() && x.size() == values.size());
+
+    return detail::scatter_density(x.data(), y.data(), values.data(), x.size(), how, norm, keywords, out);
 }
 
-#ifdef WITH_OPENCV
-void imshow(const cv::Mat &image, const std::map<std::string, std::string> &keywords = {})
+/// A 2-D histogram with xbins x ybins bins over the range of the data. The
+/// points are counted in C++ and only the counts are shown, through imshow().
+template<typename NumericX, typename NumericY>
+bool hist2d(const std::vector<NumericX>& x, const std::vector<NumericY>& y,
+            size_t xbins = 10, size_t ybins = 10, DensityNorm norm = DensityNorm::Linear,
+            const Keywords& keywords = {},
+            PyObject** out = nullptr)
 {
-    // Convert underlying type of matrix, if needed
-    cv::Mat image2;
-    NPY_TYPES npy_type = NPY_UINT8;
-    switch (image.type() & CV_MAT_DEPTH_MASK) {
-    case CV_8U:
-        image2 = image;
-        break;
-    case CV_32F:
-        image2 = image;
-        npy_type = NPY_FLOAT;
-        break;
-    default:
-        image.convertTo(image2, CV_MAKETYPE(CV_8U, image.channels()));
-    }
+    assert(x.size() == y.size());
 
-    // If color image, convert from BGR to RGB
-    switch (image2.channels()) {
-    case 3:
-        cv::cvtColor(image2, image2, CV_BGR2RGB);
-        break;
-    case 4:
-        cv::cvtColor(image2, image2, CV_BGRA2RGBA);
-    }
+    return detail::hist2d(x.data(), y.data(), x.size(), sizeof(NumericX), sizeof(NumericY),
+                          xbins, ybins, norm, keywords, out);
+}
 
-    detail::imshow(image2.data, npy_type, image2.rows, image2.cols, image2.channels(), keywords);
+template<typename NumericX, typename NumericY>
+bool hist2d(const NumericX* x, const NumericY* y, size_t n,
+            size_t xbins = 10, size_t ybins = 10, DensityNorm norm = DensityNorm::Linear,
+            const Keywords& keywords = {},
+            PyObject** out = nullptr,
+            std::ptrdiff_t xstride = sizeof(NumericX),
+            std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    return detail::hist2d(x, y, n, xstride, ystride, xbins, ybins, norm, keywords, out);
+}
+
+/// Counts the points into hexagons, gridsize of them across, laid out like
+/// matplotlib's hexbin(). Only the occupied hexagons and their counts are
+/// handed to matplotlib, as a PolyCollection.
+template<typename NumericX, typename NumericY>
+bool hexbin(const std::vector<NumericX>& x, const std::vector<NumericY>& y,
+            size_t gridsize = 100, DensityNorm norm = DensityNorm::Linear,
+            const Keywords& keywords = {},
+            PyObject** out = nullptr)
+{
+    assert(x.size() == y.size());
+
+    return detail::hexbin(x.data(), y.data(), x.size(), sizeof(NumericX), sizeof(NumericY),
+                          gridsize, norm, keywords, out);
+}
+
+template<typename NumericX, typename NumericY>
+bool hexbin(const NumericX* x, const NumericY* y, size_t n,
+            size_t gridsize = 100, DensityNorm norm = DensityNorm::Linear,
+            const Keywords& keywords = {},
+            PyObject** out = nullptr,
+            std::ptrdiff_t xstride = sizeof(NumericX),
+            std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    return detail::hexbin(x, y, n, xstride, ystride, gridsize, norm, keywords, out);
 }
-#endif // WITH_OPENCV
-#endif // WITHOUT_NUMPY
 
 template<typename NumericX, typename NumericY>
 bool scatter(const std::vector<NumericX>& x,
              const std::vector<NumericY>& y,
              const double s=1.0, // The marker size in points**2
-             const std::map<std::string, std::string> & keywords = {})
+             const Keywords& keywords = {})
 {
     detail::_interpreter::get();
 
     assert(x.size() == y.size());
 
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
-
-    PyObject* kwargs = PyDict_New();
-    PyDict_SetItemString(kwargs, "s", PyLong_FromLong(s));
-    for (const auto& it : keywords)
-    {
-        PyDict_SetItemString(kwargs, it.first.c_str(), PyString_FromString(it.second.c_str()));
-    }
-
-    PyObject* plot_args = PyTuple_New(2);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_scatter, plot_args, kwargs);
+    return detail::scatter(detail::get_array(x), detail::get_array(y), NULL, s, keywords);
+}
 
-    Py_DECREF(plot_args);
-    Py_DECREF(kwargs);
-    if(res) Py_DECREF(res);
+template<typename NumericX, typename NumericY>
+bool scatter(const NumericX* x,
+             const NumericY* y,
+             size_t n,
+             const double s=1.0, // The marker size in points**2
+             const Keywords& keywords = {},
+             std::ptrdiff_t xstride = sizeof(NumericX),
+             std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
 
-    return res;
+    return detail::scatter(detail::get_array(x, n, xstride), detail::get_array(y, n, ystride), NULL, s, keywords);
 }
 
 template<typename NumericX, typename NumericY, typename NumericColors>
-    bool scatter_colored(const std::vector<NumericX>& x,
-                 const std::vector<NumericY>& y,
-                 const std::vector<NumericColors>& colors,
-                 const double s=1.0, // The marker size in points**2
-                 const std::map<std::string, std::string> & keywords = {})
-    {
-        detail::_interpreter::get();
-
-        assert(x.size() == y.size());
-
-        PyObject* xarray = detail::get_array(x);
-        PyObject* yarray = detail::get_array(y);
-        PyObject* colors_array = detail::get_array(colors);
-
-        PyObject* kwargs = PyDict_New();
-        PyDict_SetItemString(kwargs, "s", PyLong_FromLong(s));
-        PyDict_SetItemString(kwargs, "c", colors_array);
-
-        for (const auto& it : keywords)
-        {
-            PyDict_SetItemString(kwargs, it.first.c_str(), PyString_FromString(it.second.c_str()));
-        }
+bool scatter_colored(const std::vector<NumericX>& x,
+                     const std::vector<NumericY>& y,
+                     const std::vector<NumericColors>& colors,
+                     const double s=1.0, // The marker size in points**2
+                     const Keywords& keywords = {})
+{
+    detail::_interpreter::get();
 
-        PyObject* plot_args = PyTuple_New(2);
-        PyTuple_SetItem(plot_args, 0, xarray);
-        PyTuple_SetItem(plot_args, 1, yarray);
+    assert(x.size() == y.size());
 
-        PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_scatter, plot_args, kwargs);
+    return detail::scatter(detail::get_array(x), detail::get_array(y), detail::get_array(colors), s, keywords);
+}
 
-        Py_DECREF(plot_args);
-        Py_DECREF(kwargs);
-        if(res) Py_DECREF(res);
+template<typename NumericX, typename NumericY, typename NumericColors>
+bool scatter_colored(const NumericX* x,
+                     const NumericY* y,
+                     const NumericColors* colors,
+                     size_t n,
+                     const double s=1.0, // The marker size in points**2
+                     const Keywords& keywords = {},
+                     std::ptrdiff_t xstride = sizeof(NumericX),
+                     std::ptrdiff_t ystride = sizeof(NumericY),
+                     std::ptrdiff_t colors_stride = sizeof(NumericColors))
+{
+    detail::_interpreter::get();
 
-        return res;
-    }
-    
+    return detail::scatter(detail::get_array(x, n, xstride), detail::get_array(y, n, ystride),
+                           detail::get_array(colors, n, colors_stride), s, keywords);
+}
 
 template<typename NumericX, typename NumericY, typename NumericZ>
 bool scatter(const std::vector<NumericX>& x,
              const std::vector<NumericY>& y,
              const std::vector<NumericZ>& z,
              const double s=1.0, // The marker size in points**2
-             const std::map<std::string, std::string> & keywords = {},
+             const Keywords& keywords = {},
              const long fig_number=0) {
   detail::_interpreter::get();
 
-  // Same as with plot_surface: We lazily load the modules here the first time 
-  // this function is called because I'm not sure that we can assume "matplotlib 
-  // installed" implies "mpl_toolkits installed" on all platforms, and we don't 
-  // want to require it for people who don't need 3d plots.
-  static PyObject *mpl_toolkitsmod = nullptr, *axis3dmod = nullptr;
-  if (!mpl_toolkitsmod) {
-    detail::_interpreter::get();
+  assert(x.size() == y.size());
+  assert(y.size() == z.size());
 
-    PyObject* mpl_toolkits = PyString_FromString("mpl_toolkits");
-    PyObject* axis3d = PyString_FromString("mpl_toolkits.mplot3d");
-    if (!mpl_toolkits || !axis3d) { throw std::runtime_error("couldnt create string"); }
+  PyObject *fig = detail::find_figure(fig_number);
+  PyObject *axis = detail::axes3d(fig);
+  Py_DECREF(fig);
 
-    mpl_toolkitsmod = PyImport_Import(mpl_toolkits);
-    Py_DECREF(mpl_toolkits);
-    if (!mpl_toolkitsmod) { throw std::runtime_error("Error loading module mpl_toolkits!"); }
+  PyObject *res = detail::call(detail::axes_method(axis, "scatter"),
+                               {detail::get_array(x), detail::get_array(y), detail::get_array(z)},
+                               keywords.empty() ? NULL : keywords.dict());
+  Py_DECREF(axis);
+  if (!res) throw std::runtime_error("Failed 3D line plot");
+  if (res) Py_DECREF(res);
+  return res;
 
-    axis3dmod = PyImport_Import(axis3d);
-    Py_DECREF(axis3d);
-    if (!axis3dmod) { throw std::runtime_error("Error loading module mpl_toolkits.mplot3d!"); }
-  }
+}
 
-  assert(x.size() == y.size());
-  assert(y.size() == z.size());
+namespace detail {
 
-  PyObject *xarray = detail::get_array(x);
-  PyObject *yarray = detail::get_array(y);
-  PyObject *zarray = detail::get_array(z);
+// The numbers Axes.bxp() draws a box from, as matplotlib's boxplot_stats()
+// computes them.
+struct BoxStats {
+    double mean, med, q1, q3, cilo, cihi, whislo, whishi;
+    std::vector<double> fliers;
+};
 
-  // construct positional args
-  PyObject *args = PyTuple_New(3);
-  PyTuple_SetItem(args, 0, xarray);
-  PyTuple_SetItem(args, 1, yarray);
-  PyTuple_SetItem(args, 2, zarray);
+// Statistics of n values that lie stride bytes apart; NaNs are left out.
+// Quantiles interpolate linearly like numpy.percentile(), but are found with
+// nth_element() instead of sorting. The whiskers reach the furthest values
+// within whis times the interquartile range, everything beyond is a flier.
+// With max_fliers > 0 at most that many fliers are kept, evenly spread over
+// the sorted fliers so the smallest and largest always remain.
+template<typename Numeric>
+BoxStats box_stats(const Numeric* data, size_t n, std::ptrdiff_t stride, double whis, size_t max_fliers)
+{
+    const strided<Numeric> d = {data, stride};
+    std::vector<double> v;
+    v.reserve(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const double value = d[i];
+        if (std::isnan(value)) continue;
+        v.push_back(value);
+        sum += value;
+    }
+    n = v.size();
 
-  // Build up the kw args.
-  PyObject *kwargs = PyDict_New();
+    BoxStats stats;
+    if (n == 0) {
+        stats.mean = stats.med = stats.q1 = stats.q3 = NAN;
+        stats.cilo = stats.cihi = stats.whislo = stats.whishi = NAN;
+        return stats;
+    }
+    stats.mean = sum / n;
+
+    // Every element before first is <= and every one from last on is >= the
+    // ones in [first, last), which holds the sorted position of quantile p.
+    auto quantile = [&](double p, size_t first, size_t last) {
+        const double h = p * (n - 1);
+        const size_t k = static_cast<size_t>(h);
+        std::nth_element(v.begin() + first, v.begin() + k, v.begin() + last);
+        if (k + 1 >= n || h == k) return v[k];
+        const double next = *std::min_element(v.begin() + k + 1, k + 1 < last ? v.begin() + last : v.end());
+        return v[k] + (h - k) * (next - v[k]);
+    };
+    const size_t k2 = static_cast<size_t>(0.5 * (n - 1));
+    stats.med = quantile(0.5, 0, n);
+    stats.q1 = quantile(0.25, 0, k2 + 1);
+    stats.q3 = quantile(0.75, k2, n);
+
+    const double iqr = stats.q3 - stats.q1;
+    stats.cilo = stats.med - 1.57 * iqr / std::sqrt(static_cast<double>(n));
+    stats.cihi = stats.med + 1.57 * iqr / std::sqrt(static_cast<double>(n));
+
+    const double loval = stats.q1 - whis * iqr, hival = stats.q3 + whis * iqr;
+    double lo = INFINITY, hi = -INFINITY;
+    for (double value : v) {
+        if (value >= loval) lo = std::min(lo, value);
+        if (value <= hival) hi = std::max(hi, value);
+    }
+    stats.whislo = lo > stats.q1 ? stats.q1 : lo;
+    stats.whishi = hi < stats.q3 ? stats.q3 : hi;
+
+    for (double value : v)
+        if (value < stats.whislo || value > stats.whishi)
+            stats.fliers.push_back(value);
+    if (max_fliers > 0 && stats.fliers.size() > max_fliers) {
+        std::sort(stats.fliers.begin(), stats.fliers.end());
+        std::vector<double> kept(max_fliers);
+        for (size_t i = 0; i < max_fliers; ++i)
+            kept[i] = stats.fliers[max_fliers > 1 ? i * (stats.fliers.size() - 1) / (max_fliers - 1) : 0];
+        stats.fliers.swap(kept);
+    }
+    return stats;
+}
 
-  for (std::map<std::string, std::string>::const_iterator it = keywords.begin();
-       it != keywords.end(); ++it) {
-    PyDict_SetItemString(kwargs, it->first.c_str(),
-                         PyString_FromString(it->second.c_str()));
-  }
-  PyObject *fig_args = PyTuple_New(1);
-  PyObject* fig = nullptr;
-  PyTuple_SetItem(fig_args, 0, PyLong_FromLong(fig_number));
-  PyObject *fig_exists =
-    PyObject_CallObject(detail::_interpreter::get().s_python_function_fignum_exists, fig_args);
-  if (!PyObject_IsTrue(fig_exists)) {
-    fig = PyObject_CallObject(detail::_interpreter::get().s_python_function_figure,
-      detail::_interpreter::get().s_python_empty_tuple);
-  } else {
-    fig = PyObject_CallObject(detail::_interpreter::get().s_python_function_figure,
-      fig_args);
-  }
-  Py_DECREF(fig_exists);
-  if (!fig) throw std::runtime_error("Call to figure() failed.");
+// Keywords of Axes.boxplot() that bxp() has nothing like. With any of them,
+// or a whis that is not a single number, boxplot() leaves the statistics to
+// matplotlib.
+inline bool needs_matplotlib_boxplot(const Keywords& keywords)
+{
+    static const char* const boxplot_only[] = {"sym", "bootstrap", "usermedians", "conf_intervals",
+                                               "autorange", "labels", "tick_labels", "data"};
+    for (const auto& it : keywords) {
+        for (const char* key : boxplot_only)
+            if (it.first == key) return true;
+        if (it.first == "whis") {
+            if (it.second.kind() == KeywordValue::Array) return true;
+            try { it.second.to_double(); }
+            catch (const std::exception&) { return true; }
+        }
+    }
+    return false;
+}
 
-  PyObject *gca_kwargs = PyDict_New();
-  PyDict_SetItemString(gca_kwargs, "projection", PyString_FromString("3d"));
+// The keyword Axes.boxplot() takes the tick labels as: "tick_labels" since
+// matplotlib 3.9, "labels" before.
+inline const char* boxplot_labels_keyword()
+{
+    static const char* keyword = nullptr;
+    if (!keyword) {
+        keyword = "labels";
+        PyObject* matplotlib = PyImport_ImportModule("matplotlib");
+        PyObject* version = matplotlib ? PyObject_GetAttrString(matplotlib, "__version_info__") : NULL;
+        PyObject* renamed = Py_BuildValue("(ii)", 3, 9);
+        if (version && renamed && PyObject_RichCompareBool(version, renamed, Py_GE) == 1)
+            keyword = "tick_labels";
+        PyErr_Clear();
+        Py_XDECREF(renamed);
+        Py_XDECREF(version);
+        Py_XDECREF(matplotlib);
+    }
+    return keyword;
+}
 
-  PyObject *gca = PyObject_GetAttrString(fig, "gca");
-  if (!gca) throw std::runtime_error("No gca");
-  Py_INCREF(gca);
-  PyObject *axis = PyObject_Call(
-      gca, detail::_interpreter::get().s_python_empty_tuple, gca_kwargs);
+// Draws the groups with Axes.boxplot(), which computes the statistics
+// itself. The keywords are passed on as they are.
+template<typename Group>
+bool matplotlib_boxplot(size_t groups, const Group& group, const std::vector<std::string>& labels,
+                        const Keywords& keywords)
+{
+    PyObject* data = PyList_New(groups);
+    for (size_t i = 0; i < groups; ++i)
+        PyList_SetItem(data, i, group.array(i));
 
-  if (!axis) throw std::runtime_error("No axis");
-  Py_INCREF(axis);
+    PyObject* kwargs = PyDict_New();
+    if (labels.size() == groups) {
+        PyObject* names = PyList_New(groups);
+        for (size_t i = 0; i < groups; ++i)
+            PyList_SetItem(names, i, PyString_FromString(labels[i].c_str()));
+        PyDict_SetItemString(kwargs, boxplot_labels_keyword(), names);
+        Py_DECREF(names);
+    }
+    keywords.add_to(kwargs);
+
+    PyObject* ax = NULL;
+    PyObject* fn = NULL;
+    try {
+        ax = gca();
+        fn = axes_method(ax, "boxplot");
+    } catch (...) {
+        Py_XDECREF(ax);
+        Py_DECREF(data);
+        Py_DECREF(kwargs);
+        throw;
+    }
 
-  Py_DECREF(gca);
-  Py_DECREF(gca_kwargs);
+    PyObject* res = detail::call(fn, {data}, kwargs);
 
-  PyObject *plot3 = PyObject_GetAttrString(axis, "scatter");
-  if (!plot3) throw std::runtime_error("No 3D line plot");
-  Py_INCREF(plot3);
-  PyObject *res = PyObject_Call(plot3, args, kwargs);
-  if (!res) throw std::runtime_error("Failed 3D line plot");
-  Py_DECREF(plot3);
+    Py_DECREF(ax);
+    Py_DECREF(kwargs);
 
-  Py_DECREF(axis);
-  Py_DECREF(args);
-  Py_DECREF(kwargs);
-  Py_DECREF(fig);
-  if (res) Py_DECREF(res);
-  return res;
+    if(res) Py_DECREF(res);
 
+    return res;
 }
 
-template<typename Numeric>
-bool boxplot(const std::vector<std::vector<Numeric>>& data,
-             const std::vector<std::string>& labels = {},
-             const std::map<std::string, std::string> & keywords = {})
+// Draws one box per group through Axes.bxp(). Keywords are those of bxp(),
+// except that "whis" and "notch" are taken the way boxplot() takes them;
+// those only boxplot() knows go to matplotlib_boxplot() instead.
+// group has to give the size(i), array(i) and stats(i, whis, max_fliers) of group i.
+template<typename Group>
+bool boxplot(size_t groups, const Group& group, const std::vector<std::string>& labels,
+             const Keywords& keywords, size_t max_fliers)
 {
     detail::_interpreter::get();
 
-    PyObject* listlist = detail::get_listlist(data);
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, listlist);
+    if (needs_matplotlib_boxplot(keywords))
+        return matplotlib_boxplot(groups, group, labels, keywords);
 
+    double whis = 1.5;
     PyObject* kwargs = PyDict_New();
+    for (const auto& it : keywords)
+    {
+        if (it.first == "whis") {
+            whis = it.second.to_double();
+            continue;
+        }
+        PyObject* value = it.second.to_python();
+        PyDict_SetItemString(kwargs, it.first == "notch" ? "shownotches" : it.first.c_str(), value);
+        Py_DECREF(value);
+    }
 
-    // kwargs needs the labels, if there are (the correct number of) labels
-    if (!labels.empty() && labels.size() == data.size()) {
-        PyDict_SetItemString(kwargs, "labels", detail::get_array(labels));
+    std::vector<BoxStats> stats(groups);
+    size_t total = 0;
+    for (size_t i = 0; i < groups; ++i)
+        total += group.size(i);
+    parallel_for(groups, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            stats[i] = group.stats(i, whis, max_fliers);
+    }, groups ? total / groups : 0);
+
+    PyObject* bxpstats = PyList_New(groups);
+    for (size_t i = 0; i < groups; ++i) {
+        const BoxStats& b = stats[i];
+        PyObject* box = Py_BuildValue("{sdsdsdsdsdsdsdsd}",
+                                      "mean", b.mean, "med", b.med, "q1", b.q1, "q3", b.q3,
+                                      "cilo", b.cilo, "cihi", b.cihi, "whislo", b.whislo, "whishi", b.whishi);
+        PyObject* fliers = get_array(std::move(stats[i].fliers));
+        PyDict_SetItemString(box, "fliers", fliers);
+        Py_DECREF(fliers);
+        // the labels are only used if there are (the correct number of) them
+        if (labels.size() == groups) {
+            PyObject* label = PyString_FromString(labels[i].c_str());
+            PyDict_SetItemString(box, "label", label);
+            Py_DECREF(label);
+        }
+        PyList_SetItem(bxpstats, i, box);
     }
 
-    // take care of the remaining keywords
-    for (const auto& it : keywords)
-    {
-        PyDict_SetItemString(kwargs, it.first.c_str(), PyString_FromString(it.second.c_str()));
+    PyObject* ax = NULL;
+    PyObject* bxp = NULL;
+    try {
+        ax = gca();
+        bxp = axes_method(ax, "bxp");
+    } catch (...) {
+        Py_XDECREF(ax);
+        Py_DECREF(bxpstats);
+        Py_DECREF(kwargs);
+        throw;
     }
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_boxplot, args, kwargs);
+    PyObject* res = detail::call(bxp, {bxpstats}, kwargs);
 
-    Py_DECREF(args);
+    Py_DECREF(ax);
     Py_DECREF(kwargs);
 
     if(res) Py_DECREF(res);
@@ -1192,29 +4251,58 @@ bool boxplot(const std::vector<std::vector<Numeric>>& data,
 }
 
 template<typename Numeric>
-bool boxplot(const std::vector<Numeric>& data,
-             const std::map<std::string, std::string> & keywords = {})
-{
-    detail::_interpreter::get();
-
-    PyObject* vector = detail::get_array(data);
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, vector);
+struct vector_groups {
+    const std::vector<std::vector<Numeric>>& data;
 
-    PyObject* kwargs = PyDict_New();
-    for (const auto& it : keywords)
+    size_t size(size_t i) const { return data[i].size(); }
+    PyObject* array(size_t i) const { return get_array(data[i].data(), data[i].size()); }
+    BoxStats stats(size_t i, double whis, size_t max_fliers) const
     {
-        PyDict_SetItemString(kwargs, it.first.c_str(), PyString_FromString(it.second.c_str()));
+        return box_stats(data[i].data(), data[i].size(), sizeof(Numeric), whis, max_fliers);
     }
+};
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_boxplot, args, kwargs);
+template<typename Numeric>
+struct single_group {
+    const Numeric* data;
+    size_t n;
+    std::ptrdiff_t stride;
+
+    size_t size(size_t) const { return n; }
+    PyObject* array(size_t) const { return get_array(data, n, stride); }
+    BoxStats stats(size_t, double whis, size_t max_fliers) const
+    {
+        return box_stats(data, n, stride, whis, max_fliers);
+    }
+};
 
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
+} // namespace detail
 
-    if(res) Py_DECREF(res);
+/// Draws one box per group. The quartiles, whiskers and fliers are computed
+/// in C++, for all groups in parallel, and drawn through Axes.bxp(), so only
+/// a few numbers per group reach matplotlib. max_fliers > 0 limits the fliers
+/// drawn per group to that many, spread evenly from the smallest to the
+/// largest. Keywords that only matplotlib's boxplot() understands ("sym",
+/// "bootstrap", "usermedians", "conf_intervals", "autorange", "labels",
+/// "tick_labels", "data", or a whis that is not a single number) make it
+/// draw the boxes with boxplot() instead, which ignores max_fliers.
+template<typename Numeric>
+bool boxplot(const std::vector<std::vector<Numeric>>& data,
+             const std::vector<std::string>& labels = {},
+             const Keywords& keywords = {},
+             size_t max_fliers = 0)
+{
+    const detail::vector_groups<Numeric> groups = {data};
+    return detail::boxplot(data.size(), groups, labels, keywords, max_fliers);
+}
 
-    return res;
+template<typename Numeric>
+bool boxplot(const std::vector<Numeric>& data,
+             const Keywords& keywords = {},
+             size_t max_fliers = 0)
+{
+    const detail::single_group<Numeric> group = {data.data(), data.size(), sizeof(Numeric)};
+    return detail::boxplot(1, group, {}, keywords, max_fliers);
 }
 
 template <typename Numeric>
@@ -1223,7 +4311,7 @@ bool bar(const std::vector<Numeric> &               x,
          std::string                                ec       = "black",
          std::string                                ls       = "-",
          double                                     lw       = 1.0,
-         const std::map<std::string, std::string> & keywords = {})
+         const Keywords& keywords = {})
 {
   detail::_interpreter::get();
 
@@ -1236,22 +4324,11 @@ bool bar(const std::vector<Numeric> &               x,
   PyDict_SetItemString(kwargs, "ls", PyString_FromString(ls.c_str()));
   PyDict_SetItemString(kwargs, "lw", PyFloat_FromDouble(lw));
 
-  for (std::map<std::string, std::string>::const_iterator it =
-         keywords.begin();
-       it != keywords.end();
-       ++it) {
-    PyDict_SetItemString(
-      kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-  }
-
-  PyObject * plot_args = PyTuple_New(2);
-  PyTuple_SetItem(plot_args, 0, xarray);
-  PyTuple_SetItem(plot_args, 1, yarray);
+  keywords.add_to(kwargs);
 
-  PyObject * res = PyObject_Call(
-    detail::_interpreter::get().s_python_function_bar, plot_args, kwargs);
+  PyObject * res = detail::call(
+    detail::_interpreter::get().s_python_function_bar, {xarray, yarray}, kwargs);
 
-  Py_DECREF(plot_args);
   Py_DECREF(kwargs);
   if (res) Py_DECREF(res);
 
@@ -1263,7 +4340,7 @@ bool bar(const std::vector<Numeric> &               y,
          std::string                                ec       = "black",
          std::string                                ls       = "-",
          double                                     lw       = 1.0,
-         const std::map<std::string, std::string> & keywords = {})
+         const Keywords& keywords = {})
 {
   using T = typename std::remove_reference<decltype(y)>::type::value_type;
 
@@ -1277,7 +4354,7 @@ bool bar(const std::vector<Numeric> &               y,
 
 
 template<typename Numeric>
-bool barh(const std::vector<Numeric> &x, const std::vector<Numeric> &y, std::string ec = "black", std::string ls = "-", double lw = 1.0, const std::map<std::string, std::string> &keywords = { }) {
+bool barh(const std::vector<Numeric> &x, const std::vector<Numeric> &y, std::string ec = "black", std::string ls = "-", double lw = 1.0, const Keywords& keywords = { }) {
     PyObject *xarray = detail::get_array(x);
     PyObject *yarray = detail::get_array(y);
 
@@ -1287,17 +4364,10 @@ bool barh(const std::vector<Numeric> &x, const std::vector<Numeric> &y, std::str
     PyDict_SetItemString(kwargs, "ls", PyString_FromString(ls.c_str()));
     PyDict_SetItemString(kwargs, "lw", PyFloat_FromDouble(lw));
 
-    for (std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-    }
-
-    PyObject *plot_args = PyTuple_New(2);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
+    keywords.add_to(kwargs);
 
-    PyObject *res = PyObject_Call(detail::_interpreter::get().s_python_function_barh, plot_args, kwargs);
+    PyObject *res = detail::call(detail::_interpreter::get().s_python_function_barh, {xarray, yarray}, kwargs);
 
-    Py_DECREF(plot_args);
     Py_DECREF(kwargs);
     if (res) Py_DECREF(res);
 
@@ -1305,107 +4375,103 @@ bool barh(const std::vector<Numeric> &x, const std::vector<Numeric> &y, std::str
 }
 
 
-inline bool subplots_adjust(const std::map<std::string, double>& keywords = {})
+inline bool subplots_adjust(const Keywords& keywords = {})
 {
     detail::_interpreter::get();
 
-    PyObject* kwargs = PyDict_New();
-    for (std::map<std::string, double>::const_iterator it =
-            keywords.begin(); it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(),
-                             PyFloat_FromDouble(it->second));
-    }
-
-
-    PyObject* plot_args = PyTuple_New(0);
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_subplots_adjust, plot_args, kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_subplots_adjust,
+                                 {}, keywords.empty() ? NULL : keywords.dict());
 
-    Py_DECREF(plot_args);
-    Py_DECREF(kwargs);
     if(res) Py_DECREF(res);
 
     return res;
 }
 
-template< typename Numeric>
-bool named_hist(std::string label,const std::vector<Numeric>& y, long bins=10, std::string color="b", double alpha=1.0)
+template< typename Numeric>
+bool named_hist(std::string label,const std::vector<Numeric>& y, long bins=10, std::string color="b", double alpha=1.0)
+{
+    detail::_interpreter::get();
+
+    return detail::hist(detail::auto_histogram(y.data(), y.size(), bins, sizeof(Numeric)),
+                        color, alpha, false, label);
+}
+
+template<typename Numeric>
+bool named_hist(std::string label, const Numeric* y, size_t n, long bins=10, std::string color="b", double alpha=1.0,
+                std::ptrdiff_t ystride = sizeof(Numeric))
 {
     detail::_interpreter::get();
 
-    PyObject* yarray = detail::get_array(y);
-
-    PyObject* kwargs = PyDict_New();
-    PyDict_SetItemString(kwargs, "label", PyString_FromString(label.c_str()));
-    PyDict_SetItemString(kwargs, "bins", PyLong_FromLong(bins));
-    PyDict_SetItemString(kwargs, "color", PyString_FromString(color.c_str()));
-    PyDict_SetItemString(kwargs, "alpha", PyFloat_FromDouble(alpha));
+    return detail::hist(detail::auto_histogram(y, n, bins, ystride), color, alpha, false, label);
+}
 
+inline bool named_hist(std::string label, const Histogram& h, std::string color="b", double alpha=1.0)
+{
+    detail::_interpreter::get();
 
-    PyObject* plot_args = PyTuple_New(1);
-    PyTuple_SetItem(plot_args, 0, yarray);
+    return detail::hist(h, color, alpha, false, label);
+}
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_hist, plot_args, kwargs);
+template<typename NumericX, typename NumericY>
+bool plot(const std::vector<NumericX>& x, const std::vector<NumericY>& y, const std::string& s = "")
+{
+    assert(x.size() == y.size());
 
-    Py_DECREF(plot_args);
-    Py_DECREF(kwargs);
-    if(res) Py_DECREF(res);
+    detail::_interpreter::get();
 
-    return res;
+    PyObject *xarray, *yarray;
+    detail::get_line_arrays(x.data(), sizeof(NumericX), y.data(), sizeof(NumericY), x.size(), xarray, yarray);
+    return detail::plot(detail::_interpreter::get().s_python_function_plot, xarray, yarray, s, NULL);
 }
 
 template<typename NumericX, typename NumericY>
-bool plot(const std::vector<NumericX>& x, const std::vector<NumericY>& y, const std::string& s = "")
+bool plot(std::vector<NumericX>&& x, std::vector<NumericY>&& y, const std::string& s = "")
 {
     assert(x.size() == y.size());
 
     detail::_interpreter::get();
 
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
+    return detail::plot(detail::_interpreter::get().s_python_function_plot,
+                        detail::get_array(std::move(x)), detail::get_array(std::move(y)), s, NULL);
+}
 
-    PyObject* pystring = PyString_FromString(s.c_str());
+/// Shares ownership of the data with matplotlib, e.g. to keep a buffer that
+/// is updated in place plotted without copying it.
+template<typename NumericX, typename NumericY>
+bool plot(const std::shared_ptr<std::vector<NumericX>>& x, const std::shared_ptr<std::vector<NumericY>>& y, const std::string& s = "")
+{
+    assert(x->size() == y->size());
 
-    PyObject* plot_args = PyTuple_New(3);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, pystring);
+    detail::_interpreter::get();
 
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_plot, plot_args);
+    return detail::plot(detail::_interpreter::get().s_python_function_plot,
+                        detail::get_array(x), detail::get_array(y), s, NULL);
+}
 
-    Py_DECREF(plot_args);
-    if(res) Py_DECREF(res);
+template<typename NumericX, typename NumericY>
+bool plot(const NumericX* x, const NumericY* y, size_t n, const std::string& s = "",
+          std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
 
-    return res;
+    PyObject *xarray, *yarray;
+    detail::get_line_arrays(x, xstride, y, ystride, n, xarray, yarray);
+    return detail::plot(detail::_interpreter::get().s_python_function_plot, xarray, yarray, s, NULL);
 }
 
 template <typename NumericX, typename NumericY, typename NumericZ>
 bool contour(const std::vector<NumericX>& x, const std::vector<NumericY>& y,
              const std::vector<NumericZ>& z,
-             const std::map<std::string, std::string>& keywords = {}) {
+             const Keywords& keywords = {}) {
     assert(x.size() == y.size() && x.size() == z.size());
 
     PyObject* xarray = detail::get_array(x);
     PyObject* yarray = detail::get_array(y);
     PyObject* zarray = detail::get_array(z);
 
-    PyObject* plot_args = PyTuple_New(3);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, zarray);
-
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for (std::map<std::string, std::string>::const_iterator it = keywords.begin();
-         it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-    }
-
-    PyObject* res =
-            PyObject_Call(detail::_interpreter::get().s_python_function_contour, plot_args, kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_contour,
+                                 {xarray, yarray, zarray}, keywords.empty() ? NULL : keywords.dict());
 
-    Py_DECREF(kwargs);
-    Py_DECREF(plot_args);
     if (res)
         Py_DECREF(res);
 
@@ -1413,7 +4479,7 @@ bool contour(const std::vector<NumericX>& x, const std::vector<NumericY>& y,
 }
 
 template<typename NumericX, typename NumericY, typename NumericU, typename NumericW>
-bool quiver(const std::vector<NumericX>& x, const std::vector<NumericY>& y, const std::vector<NumericU>& u, const std::vector<NumericW>& w, const std::map<std::string, std::string>& keywords = {})
+bool quiver(const std::vector<NumericX>& x, const std::vector<NumericY>& y, const std::vector<NumericU>& u, const std::vector<NumericW>& w, const Keywords& keywords = {})
 {
     assert(x.size() == y.size() && x.size() == u.size() && u.size() == w.size());
 
@@ -1424,24 +4490,9 @@ bool quiver(const std::vector<NumericX>& x, const std::vector<NumericY>& y, cons
     PyObject* uarray = detail::get_array(u);
     PyObject* warray = detail::get_array(w);
 
-    PyObject* plot_args = PyTuple_New(4);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, uarray);
-    PyTuple_SetItem(plot_args, 3, warray);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_quiver,
+                                 {xarray, yarray, uarray, warray}, keywords.empty() ? NULL : keywords.dict());
 
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-    {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-    }
-
-    PyObject* res = PyObject_Call(
-            detail::_interpreter::get().s_python_function_quiver, plot_args, kwargs);
-
-    Py_DECREF(kwargs);
-    Py_DECREF(plot_args);
     if (res)
         Py_DECREF(res);
 
@@ -1449,87 +4500,29 @@ bool quiver(const std::vector<NumericX>& x, const std::vector<NumericY>& y, cons
 }
 
 template<typename NumericX, typename NumericY, typename NumericZ, typename NumericU, typename NumericW, typename NumericV>
-bool quiver(const std::vector<NumericX>& x, const std::vector<NumericY>& y, const std::vector<NumericZ>& z, const std::vector<NumericU>& u, const std::vector<NumericW>& w, const std::vector<NumericV>& v, const std::map<std::string, std::string>& keywords = {})
+bool quiver(const std::vector<NumericX>& x, const std::vector<NumericY>& y, const std::vector<NumericZ>& z, const std::vector<NumericU>& u, const std::vector<NumericW>& w, const std::vector<NumericV>& v, const Keywords& keywords = {})
 {
-  //set up 3d axes stuff
-  static PyObject *mpl_toolkitsmod = nullptr, *axis3dmod = nullptr;
-  if (!mpl_toolkitsmod) {
-    detail::_interpreter::get();
-
-    PyObject* mpl_toolkits = PyString_FromString("mpl_toolkits");
-    PyObject* axis3d = PyString_FromString("mpl_toolkits.mplot3d");
-    if (!mpl_toolkits || !axis3d) { throw std::runtime_error("couldnt create string"); }
-
-    mpl_toolkitsmod = PyImport_Import(mpl_toolkits);
-    Py_DECREF(mpl_toolkits);
-    if (!mpl_toolkitsmod) { throw std::runtime_error("Error loading module mpl_toolkits!"); }
-
-    axis3dmod = PyImport_Import(axis3d);
-    Py_DECREF(axis3d);
-    if (!axis3dmod) { throw std::runtime_error("Error loading module mpl_toolkits.mplot3d!"); }
-  }
-  
   //assert sizes match up
   assert(x.size() == y.size() && x.size() == u.size() && u.size() == w.size() && x.size() == z.size() && x.size() == v.size() && u.size() == v.size());
 
   //set up parameters
   detail::_interpreter::get();
 
-  PyObject* xarray = detail::get_array(x);
-  PyObject* yarray = detail::get_array(y);
-  PyObject* zarray = detail::get_array(z);
-  PyObject* uarray = detail::get_array(u);
-  PyObject* warray = detail::get_array(w);
-  PyObject* varray = detail::get_array(v);
-
-  PyObject* plot_args = PyTuple_New(6);
-  PyTuple_SetItem(plot_args, 0, xarray);
-  PyTuple_SetItem(plot_args, 1, yarray);
-  PyTuple_SetItem(plot_args, 2, zarray);
-  PyTuple_SetItem(plot_args, 3, uarray);
-  PyTuple_SetItem(plot_args, 4, warray);
-  PyTuple_SetItem(plot_args, 5, varray);
-
-  // construct keyword args
-  PyObject* kwargs = PyDict_New();
-  for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-  {
-      PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-  }
-    
-  //get figure gca to enable 3d projection
+  //get a new figure with 3d axes
   PyObject *fig =
-      PyObject_CallObject(detail::_interpreter::get().s_python_function_figure,
-                          detail::_interpreter::get().s_python_empty_tuple);
+      detail::call_now(detail::_interpreter::get().s_python_function_figure, {});
   if (!fig) throw std::runtime_error("Call to figure() failed.");
+  PyObject *axis = detail::axes3d(fig);
+  Py_DECREF(fig);
 
-  PyObject *gca_kwargs = PyDict_New();
-  PyDict_SetItemString(gca_kwargs, "projection", PyString_FromString("3d"));
-
-  PyObject *gca = PyObject_GetAttrString(fig, "gca");
-  if (!gca) throw std::runtime_error("No gca");
-  Py_INCREF(gca);
-  PyObject *axis = PyObject_Call(
-      gca, detail::_interpreter::get().s_python_empty_tuple, gca_kwargs);
-
-  if (!axis) throw std::runtime_error("No axis");
-  Py_INCREF(axis);
-  Py_DECREF(gca);
-  Py_DECREF(gca_kwargs);
-  
   //plot our boys bravely, plot them strongly, plot them with a wink and clap
-  PyObject *plot3 = PyObject_GetAttrString(axis, "quiver");
-  if (!plot3) throw std::runtime_error("No 3D line plot");
-  Py_INCREF(plot3);
-  PyObject* res = PyObject_Call(
-          plot3, plot_args, kwargs);
-  if (!res) throw std::runtime_error("Failed 3D plot");
-  Py_DECREF(plot3);
+  PyObject* res = detail::call(detail::axes_method(axis, "quiver"),
+                               {detail::get_array(x), detail::get_array(y), detail::get_array(z),
+                                detail::get_array(u), detail::get_array(w), detail::get_array(v)},
+                               keywords.empty() ? NULL : keywords.dict());
   Py_DECREF(axis);
-  Py_DECREF(kwargs);
-  Py_DECREF(plot_args);
-  if (res)
-      Py_DECREF(res);
+  if (!res) throw std::runtime_error("Failed 3D plot");
+  Py_DECREF(res);
 
   return res;
 }
@@ -1541,24 +4534,18 @@ bool stem(const std::vector<NumericX>& x, const std::vector<NumericY>& y, const
 
     detail::_interpreter::get();
 
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
-
-    PyObject* pystring = PyString_FromString(s.c_str());
-
-    PyObject* plot_args = PyTuple_New(3);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, pystring);
-
-    PyObject* res = PyObject_CallObject(
-            detail::_interpreter::get().s_python_function_stem, plot_args);
+    return detail::plot(detail::_interpreter::get().s_python_function_stem,
+                        detail::get_array(x), detail::get_array(y), s, NULL);
+}
 
-    Py_DECREF(plot_args);
-    if (res)
-        Py_DECREF(res);
+template<typename NumericX, typename NumericY>
+bool stem(const NumericX* x, const NumericY* y, size_t n, const std::string& s = "",
+          std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
 
-    return res;
+    return detail::plot(detail::_interpreter::get().s_python_function_stem,
+                        detail::get_array(x, n, xstride), detail::get_array(y, n, ystride), s, NULL);
 }
 
 template<typename NumericX, typename NumericY>
@@ -1568,22 +4555,18 @@ bool semilogx(const std::vector<NumericX>& x, const std::vector<NumericY>& y, co
 
     detail::_interpreter::get();
 
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
-
-    PyObject* pystring = PyString_FromString(s.c_str());
-
-    PyObject* plot_args = PyTuple_New(3);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, pystring);
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_semilogx, plot_args);
+    return detail::plot(detail::_interpreter::get().s_python_function_semilogx,
+                        detail::get_array(x), detail::get_array(y), s, NULL);
+}
 
-    Py_DECREF(plot_args);
-    if(res) Py_DECREF(res);
+template<typename NumericX, typename NumericY>
+bool semilogx(const NumericX* x, const NumericY* y, size_t n, const std::string& s = "",
+              std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
 
-    return res;
+    return detail::plot(detail::_interpreter::get().s_python_function_semilogx,
+                        detail::get_array(x, n, xstride), detail::get_array(y, n, ystride), s, NULL);
 }
 
 template<typename NumericX, typename NumericY>
@@ -1593,22 +4576,18 @@ bool semilogy(const std::vector<NumericX>& x, const std::vector<NumericY>& y, co
 
     detail::_interpreter::get();
 
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
-
-    PyObject* pystring = PyString_FromString(s.c_str());
-
-    PyObject* plot_args = PyTuple_New(3);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, pystring);
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_semilogy, plot_args);
+    return detail::plot(detail::_interpreter::get().s_python_function_semilogy,
+                        detail::get_array(x), detail::get_array(y), s, NULL);
+}
 
-    Py_DECREF(plot_args);
-    if(res) Py_DECREF(res);
+template<typename NumericX, typename NumericY>
+bool semilogy(const NumericX* x, const NumericY* y, size_t n, const std::string& s = "",
+              std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
 
-    return res;
+    return detail::plot(detail::_interpreter::get().s_python_function_semilogy,
+                        detail::get_array(x, n, xstride), detail::get_array(y, n, ystride), s, NULL);
 }
 
 template<typename NumericX, typename NumericY>
@@ -1618,59 +4597,38 @@ bool loglog(const std::vector<NumericX>& x, const std::vector<NumericY>& y, cons
 
     detail::_interpreter::get();
 
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
-
-    PyObject* pystring = PyString_FromString(s.c_str());
-
-    PyObject* plot_args = PyTuple_New(3);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, pystring);
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_loglog, plot_args);
+    return detail::plot(detail::_interpreter::get().s_python_function_loglog,
+                        detail::get_array(x), detail::get_array(y), s, NULL);
+}
 
-    Py_DECREF(plot_args);
-    if(res) Py_DECREF(res);
+template<typename NumericX, typename NumericY>
+bool loglog(const NumericX* x, const NumericY* y, size_t n, const std::string& s = "",
+            std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
 
-    return res;
+    return detail::plot(detail::_interpreter::get().s_python_function_loglog,
+                        detail::get_array(x, n, xstride), detail::get_array(y, n, ystride), s, NULL);
 }
 
 template<typename NumericX, typename NumericY>
-bool errorbar(const std::vector<NumericX> &x, const std::vector<NumericY> &y, const std::vector<NumericX> &yerr, const std::map<std::string, std::string> &keywords = {})
+bool errorbar(const std::vector<NumericX> &x, const std::vector<NumericY> &y, const std::vector<NumericX> &yerr, const Keywords& keywords = {})
 {
     assert(x.size() == y.size());
 
     detail::_interpreter::get();
 
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
-    PyObject* yerrarray = detail::get_array(yerr);
-
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-    {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyString_FromString(it->second.c_str()));
-    }
-
-    PyDict_SetItemString(kwargs, "yerr", yerrarray);
-
-    PyObject *plot_args = PyTuple_New(2);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-
-    PyObject *res = PyObject_Call(detail::_interpreter::get().s_python_function_errorbar, plot_args, kwargs);
-
-    Py_DECREF(kwargs);
-    Py_DECREF(plot_args);
+    return detail::errorbar(detail::get_array(x), detail::get_array(y), detail::get_array(yerr), keywords);
+}
 
-    if (res)
-        Py_DECREF(res);
-    else
-        throw std::runtime_error("Call to errorbar() failed.");
+template<typename NumericX, typename NumericY>
+bool errorbar(const NumericX* x, const NumericY* y, const NumericX* yerr, size_t n, const Keywords& keywords = {},
+              std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY), std::ptrdiff_t yerr_stride = sizeof(NumericX))
+{
+    detail::_interpreter::get();
 
-    return res;
+    return detail::errorbar(detail::get_array(x, n, xstride), detail::get_array(y, n, ystride),
+                            detail::get_array(yerr, n, yerr_stride), keywords);
 }
 
 template<typename Numeric>
@@ -1678,25 +4636,22 @@ bool named_plot(const std::string& name, const std::vector<Numeric>& y, const st
 {
     detail::_interpreter::get();
 
-    PyObject* kwargs = PyDict_New();
-    PyDict_SetItemString(kwargs, "label", PyString_FromString(name.c_str()));
-
-    PyObject* yarray = detail::get_array(y);
-
-    PyObject* pystring = PyString_FromString(format.c_str());
-
-    PyObject* plot_args = PyTuple_New(2);
-
-    PyTuple_SetItem(plot_args, 0, yarray);
-    PyTuple_SetItem(plot_args, 1, pystring);
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_plot, plot_args, kwargs);
+    PyObject *xarray, *yarray;
+    detail::get_line_arrays(static_cast<const Numeric*>(NULL), 0, y.data(), sizeof(Numeric), y.size(), xarray, yarray);
+    return detail::named_plot(detail::_interpreter::get().s_python_function_plot,
+                              name, xarray, yarray, format);
+}
 
-    Py_DECREF(kwargs);
-    Py_DECREF(plot_args);
-    if (res) Py_DECREF(res);
+template<typename Numeric>
+bool named_plot(const std::string& name, const Numeric* y, size_t n, const std::string& format = "",
+                std::ptrdiff_t ystride = sizeof(Numeric))
+{
+    detail::_interpreter::get();
 
-    return res;
+    PyObject *xarray, *yarray;
+    detail::get_line_arrays(static_cast<const Numeric*>(NULL), 0, y, ystride, n, xarray, yarray);
+    return detail::named_plot(detail::_interpreter::get().s_python_function_plot,
+                              name, xarray, yarray, format);
 }
 
 template<typename NumericX, typename NumericY>
@@ -1704,26 +4659,40 @@ bool named_plot(const std::string& name, const std::vector<NumericX>& x, const s
 {
     detail::_interpreter::get();
 
-    PyObject* kwargs = PyDict_New();
-    PyDict_SetItemString(kwargs, "label", PyString_FromString(name.c_str()));
+    PyObject *xarray, *yarray;
+    detail::get_line_arrays(x.data(), sizeof(NumericX), y.data(), sizeof(NumericY), x.size(), xarray, yarray);
+    return detail::named_plot(detail::_interpreter::get().s_python_function_plot,
+                              name, xarray, yarray, format);
+}
 
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
+template<typename NumericX, typename NumericY>
+bool named_plot(const std::string& name, std::vector<NumericX>&& x, std::vector<NumericY>&& y, const std::string& format = "")
+{
+    detail::_interpreter::get();
 
-    PyObject* pystring = PyString_FromString(format.c_str());
+    return detail::named_plot(detail::_interpreter::get().s_python_function_plot,
+                              name, detail::get_array(std::move(x)), detail::get_array(std::move(y)), format);
+}
 
-    PyObject* plot_args = PyTuple_New(3);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, pystring);
+template<typename NumericX, typename NumericY>
+bool named_plot(const std::string& name, const std::shared_ptr<std::vector<NumericX>>& x, const std::shared_ptr<std::vector<NumericY>>& y, const std::string& format = "")
+{
+    detail::_interpreter::get();
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_plot, plot_args, kwargs);
+    return detail::named_plot(detail::_interpreter::get().s_python_function_plot,
+                              name, detail::get_array(x), detail::get_array(y), format);
+}
 
-    Py_DECREF(kwargs);
-    Py_DECREF(plot_args);
-    if (res) Py_DECREF(res);
+template<typename NumericX, typename NumericY>
+bool named_plot(const std::string& name, const NumericX* x, const NumericY* y, size_t n, const std::string& format = "",
+                std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
 
-    return res;
+    PyObject *xarray, *yarray;
+    detail::get_line_arrays(x, xstride, y, ystride, n, xarray, yarray);
+    return detail::named_plot(detail::_interpreter::get().s_python_function_plot,
+                              name, xarray, yarray, format);
 }
 
 template<typename NumericX, typename NumericY>
@@ -1731,26 +4700,18 @@ bool named_semilogx(const std::string& name, const std::vector<NumericX>& x, con
 {
     detail::_interpreter::get();
 
-    PyObject* kwargs = PyDict_New();
-    PyDict_SetItemString(kwargs, "label", PyString_FromString(name.c_str()));
-
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
-
-    PyObject* pystring = PyString_FromString(format.c_str());
-
-    PyObject* plot_args = PyTuple_New(3);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, pystring);
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_semilogx, plot_args, kwargs);
+    return detail::named_plot(detail::_interpreter::get().s_python_function_semilogx,
+                              name, detail::get_array(x), detail::get_array(y), format);
+}
 
-    Py_DECREF(kwargs);
-    Py_DECREF(plot_args);
-    if (res) Py_DECREF(res);
+template<typename NumericX, typename NumericY>
+bool named_semilogx(const std::string& name, const NumericX* x, const NumericY* y, size_t n, const std::string& format = "",
+                    std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
 
-    return res;
+    return detail::named_plot(detail::_interpreter::get().s_python_function_semilogx,
+                              name, detail::get_array(x, n, xstride), detail::get_array(y, n, ystride), format);
 }
 
 template<typename NumericX, typename NumericY>
@@ -1758,26 +4719,18 @@ bool named_semilogy(const std::string& name, const std::vector<NumericX>& x, con
 {
     detail::_interpreter::get();
 
-    PyObject* kwargs = PyDict_New();
-    PyDict_SetItemString(kwargs, "label", PyString_FromString(name.c_str()));
-
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
-
-    PyObject* pystring = PyString_FromString(format.c_str());
-
-    PyObject* plot_args = PyTuple_New(3);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, pystring);
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_semilogy, plot_args, kwargs);
+    return detail::named_plot(detail::_interpreter::get().s_python_function_semilogy,
+                              name, detail::get_array(x), detail::get_array(y), format);
+}
 
-    Py_DECREF(kwargs);
-    Py_DECREF(plot_args);
-    if (res) Py_DECREF(res);
+template<typename NumericX, typename NumericY>
+bool named_semilogy(const std::string& name, const NumericX* x, const NumericY* y, size_t n, const std::string& format = "",
+                    std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
 
-    return res;
+    return detail::named_plot(detail::_interpreter::get().s_python_function_semilogy,
+                              name, detail::get_array(x, n, xstride), detail::get_array(y, n, ystride), format);
 }
 
 template<typename NumericX, typename NumericY>
@@ -1785,25 +4738,18 @@ bool named_loglog(const std::string& name, const std::vector<NumericX>& x, const
 {
     detail::_interpreter::get();
 
-    PyObject* kwargs = PyDict_New();
-    PyDict_SetItemString(kwargs, "label", PyString_FromString(name.c_str()));
-
-    PyObject* xarray = detail::get_array(x);
-    PyObject* yarray = detail::get_array(y);
-
-    PyObject* pystring = PyString_FromString(format.c_str());
-
-    PyObject* plot_args = PyTuple_New(3);
-    PyTuple_SetItem(plot_args, 0, xarray);
-    PyTuple_SetItem(plot_args, 1, yarray);
-    PyTuple_SetItem(plot_args, 2, pystring);
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_loglog, plot_args, kwargs);
+    return detail::named_plot(detail::_interpreter::get().s_python_function_loglog,
+                              name, detail::get_array(x), detail::get_array(y), format);
+}
 
-    Py_DECREF(kwargs);
-    Py_DECREF(plot_args);
-    if (res) Py_DECREF(res);
+template<typename NumericX, typename NumericY>
+bool named_loglog(const std::string& name, const NumericX* x, const NumericY* y, size_t n, const std::string& format = "",
+                  std::ptrdiff_t xstride = sizeof(NumericX), std::ptrdiff_t ystride = sizeof(NumericY))
+{
+    detail::_interpreter::get();
 
-    return res;
+    return detail::named_plot(detail::_interpreter::get().s_python_function_loglog,
+                              name, detail::get_array(x, n, xstride), detail::get_array(y, n, ystride), format);
 }
 
 template<typename Numeric>
@@ -1815,7 +4761,7 @@ bool plot(const std::vector<Numeric>& y, const std::string& format = "")
 }
 
 template<typename Numeric>
-bool plot(const std::vector<Numeric>& y, const std::map<std::string, std::string>& keywords)
+bool plot(const std::vector<Numeric>& y, const Keywords& keywords)
 {
     std::vector<Numeric> x(y.size());
     for(size_t i=0; i<x.size(); ++i) x.at(i) = i;
@@ -1835,39 +4781,24 @@ void text(Numeric x, Numeric y, const std::string& s = "")
 {
     detail::_interpreter::get();
 
-    PyObject* args = PyTuple_New(3);
-    PyTuple_SetItem(args, 0, PyFloat_FromDouble(x));
-    PyTuple_SetItem(args, 1, PyFloat_FromDouble(y));
-    PyTuple_SetItem(args, 2, PyString_FromString(s.c_str()));
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_text, args);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_text,
+                                 {PyFloat_FromDouble(x), PyFloat_FromDouble(y), PyString_FromString(s.c_str())});
     if(!res) throw std::runtime_error("Call to text() failed.");
 
-    Py_DECREF(args);
     Py_DECREF(res);
 }
 
-inline void colorbar(PyObject* mappable = NULL, const std::map<std::string, float>& keywords = {})
+inline void colorbar(PyObject* mappable = NULL, const Keywords& keywords = {})
 {
     if (mappable == NULL)
         throw std::runtime_error("Must call colorbar with PyObject* returned from an image, contour, surface, etc.");
 
     detail::_interpreter::get();
 
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, mappable);
-
-    PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, float>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-    {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyFloat_FromDouble(it->second));
-    }
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_colorbar, args, kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_colorbar,
+                                 {mappable}, keywords.empty() ? NULL : keywords.dict());
     if(!res) throw std::runtime_error("Call to colorbar() failed.");
 
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
     Py_DECREF(res);
 }
 
@@ -1875,20 +4806,18 @@ inline void colorbar(PyObject* mappable = NULL, const std::map<std::string, floa
 inline long figure(long number = -1)
 {
     detail::_interpreter::get();
+    detail::release_axes_methods();
 
     PyObject *res;
     if (number == -1)
-        res = PyObject_CallObject(detail::_interpreter::get().s_python_function_figure, detail::_interpreter::get().s_python_empty_tuple);
+        res = detail::call_now(detail::_interpreter::get().s_python_function_figure, {});
     else {
         assert(number > 0);
 
         // Make sure interpreter is initialised
         detail::_interpreter::get();
 
-        PyObject *args = PyTuple_New(1);
-        PyTuple_SetItem(args, 0, PyLong_FromLong(number));
-        res = PyObject_CallObject(detail::_interpreter::get().s_python_function_figure, args);
-        Py_DECREF(args);
+        res = detail::call_now(detail::_interpreter::get().s_python_function_figure, {PyLong_FromLong(number)});
     }
 
     if(!res) throw std::runtime_error("Call to figure() failed.");
@@ -1907,14 +4836,12 @@ inline bool fignum_exists(long number)
 {
     detail::_interpreter::get();
 
-    PyObject *args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, PyLong_FromLong(number));
-    PyObject *res = PyObject_CallObject(detail::_interpreter::get().s_python_function_fignum_exists, args);
+    PyObject *res = detail::call_now(detail::_interpreter::get().s_python_function_fignum_exists,
+                                     {PyLong_FromLong(number)});
     if(!res) throw std::runtime_error("Call to fignum_exists() failed.");
 
     bool ret = PyObject_IsTrue(res);
     Py_DECREF(res);
-    Py_DECREF(args);
 
     return ret;
 }
@@ -1932,8 +4859,7 @@ inline void figure_size(size_t w, size_t h)
     PyDict_SetItemString(kwargs, "figsize", size);
     PyDict_SetItemString(kwargs, "dpi", PyLong_FromSize_t(dpi));
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_figure,
-            detail::_interpreter::get().s_python_empty_tuple, kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_figure, {}, kwargs);
 
     Py_DECREF(kwargs);
 
@@ -1945,27 +4871,20 @@ inline void legend()
 {
     detail::_interpreter::get();
 
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_legend, detail::_interpreter::get().s_python_empty_tuple);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_legend, {});
     if(!res) throw std::runtime_error("Call to legend() failed.");
 
     Py_DECREF(res);
 }
 
-inline void legend(const std::map<std::string, std::string>& keywords)
+inline void legend(const Keywords& keywords)
 {
   detail::_interpreter::get();
 
-  // construct keyword args
-  PyObject* kwargs = PyDict_New();
-  for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-  {
-    PyDict_SetItemString(kwargs, it->first.c_str(), PyString_FromString(it->second.c_str()));
-  }
-
-  PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_legend, detail::_interpreter::get().s_python_empty_tuple, kwargs);
+  PyObject* res = detail::call(detail::_interpreter::get().s_python_function_legend,
+                               {}, keywords.empty() ? NULL : keywords.dict());
   if(!res) throw std::runtime_error("Call to legend() failed.");
 
-  Py_DECREF(kwargs);
   Py_DECREF(res);
 }
 
@@ -1974,55 +4893,23 @@ inline void set_aspect(Numeric ratio)
 {
     detail::_interpreter::get();
 
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, PyFloat_FromDouble(ratio));
-    PyObject* kwargs = PyDict_New();
-
-    PyObject *ax =
-    PyObject_CallObject(detail::_interpreter::get().s_python_function_gca,
-      detail::_interpreter::get().s_python_empty_tuple);
-    if (!ax) throw std::runtime_error("Call to gca() failed.");
-    Py_INCREF(ax);
-
-    PyObject *set_aspect = PyObject_GetAttrString(ax, "set_aspect");
-    if (!set_aspect) throw std::runtime_error("Attribute set_aspect not found.");
-    Py_INCREF(set_aspect);
-
-    PyObject *res = PyObject_Call(set_aspect, args, kwargs);
-    if (!res) throw std::runtime_error("Call to set_aspect() failed.");
-    Py_DECREF(set_aspect);
-
+    PyObject *ax = detail::gca();
+    PyObject *res = detail::call(detail::axes_method(ax, "set_aspect"), {PyFloat_FromDouble(ratio)});
     Py_DECREF(ax);
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
+    if (!res) throw std::runtime_error("Call to set_aspect() failed.");
+    Py_DECREF(res);
 }
 
-inline void set_aspect_equal()
-{
-    // expect ratio == "equal". Leaving error handling to matplotlib.
-    detail::_interpreter::get();
-
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, PyString_FromString("equal"));
-    PyObject* kwargs = PyDict_New();
-
-    PyObject *ax =
-    PyObject_CallObject(detail::_interpreter::get().s_python_function_gca,
-      detail::_interpreter::get().s_python_empty_tuple);
-    if (!ax) throw std::runtime_error("Call to gca() failed.");
-    Py_INCREF(ax);
-
-    PyObject *set_aspect = PyObject_GetAttrString(ax, "set_aspect");
-    if (!set_aspect) throw std::runtime_error("Attribute set_aspect not found.");
-    Py_INCREF(set_aspect);
-
-    PyObject *res = PyObject_Call(set_aspect, args, kwargs);
-    if (!res) throw std::runtime_error("Call to set_aspect() failed.");
-    Py_DECREF(set_aspect);
+inline void set_aspect_equal()
+{
+    // expect ratio == "equal". Leaving error handling to matplotlib.
+    detail::_interpreter::get();
 
+    PyObject *ax = detail::gca();
+    PyObject *res = detail::call(detail::axes_method(ax, "set_aspect"), {PyString_FromString("equal")});
     Py_DECREF(ax);
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
+    if (!res) throw std::runtime_error("Call to set_aspect() failed.");
+    Py_DECREF(res);
 }
 
 template<typename Numeric>
@@ -2034,13 +4921,9 @@ void ylim(Numeric left, Numeric right)
     PyList_SetItem(list, 0, PyFloat_FromDouble(left));
     PyList_SetItem(list, 1, PyFloat_FromDouble(right));
 
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, list);
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_ylim, args);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_ylim, {list});
     if(!res) throw std::runtime_error("Call to ylim() failed.");
 
-    Py_DECREF(args);
     Py_DECREF(res);
 }
 
@@ -2053,48 +4936,42 @@ void xlim(Numeric left, Numeric right)
     PyList_SetItem(list, 0, PyFloat_FromDouble(left));
     PyList_SetItem(list, 1, PyFloat_FromDouble(right));
 
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, list);
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_xlim, args);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_xlim, {list});
     if(!res) throw std::runtime_error("Call to xlim() failed.");
 
-    Py_DECREF(args);
     Py_DECREF(res);
 }
 
 
 inline std::array<double, 2> xlim()
 {
-    PyObject* args = PyTuple_New(0);
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_xlim, args);
+    PyObject* res = detail::call_now(detail::_interpreter::get().s_python_function_xlim, {});
 
     if(!res) throw std::runtime_error("Call to xlim() failed.");
 
-    Py_DECREF(res);
-
     PyObject* left = PyTuple_GetItem(res,0);
     PyObject* right = PyTuple_GetItem(res,1);
-    return { PyFloat_AsDouble(left), PyFloat_AsDouble(right) };
+    std::array<double, 2> arr = {{ PyFloat_AsDouble(left), PyFloat_AsDouble(right) }};
+    Py_DECREF(res);
+    return arr;
 }
 
 
 inline std::array<double, 2> ylim()
 {
-    PyObject* args = PyTuple_New(0);
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_ylim, args);
+    PyObject* res = detail::call_now(detail::_interpreter::get().s_python_function_ylim, {});
 
     if(!res) throw std::runtime_error("Call to ylim() failed.");
 
-    Py_DECREF(res);
-
     PyObject* left = PyTuple_GetItem(res,0);
     PyObject* right = PyTuple_GetItem(res,1);
-    return { PyFloat_AsDouble(left), PyFloat_AsDouble(right) };
+    std::array<double, 2> arr = {{ PyFloat_AsDouble(left), PyFloat_AsDouble(right) }};
+    Py_DECREF(res);
+    return arr;
 }
 
 template<typename Numeric>
-inline void xticks(const std::vector<Numeric> &ticks, const std::vector<std::string> &labels = {}, const std::map<std::string, std::string>& keywords = {})
+inline void xticks(const std::vector<Numeric> &ticks, const std::vector<std::string> &labels = {}, const Keywords& keywords = {})
 {
     assert(labels.size() == 0 || ticks.size() == labels.size());
 
@@ -2103,47 +4980,29 @@ inline void xticks(const std::vector<Numeric> &ticks, const std::vector<std::str
     // using numpy array
     PyObject* ticksarray = detail::get_array(ticks);
 
-    PyObject* args;
-    if(labels.size() == 0) {
-        // construct positional args
-        args = PyTuple_New(1);
-        PyTuple_SetItem(args, 0, ticksarray);
-    } else {
+    PyObject* args[2] = {ticksarray, NULL};
+    if(labels.size() != 0) {
         // make tuple of tick labels
-        PyObject* labelstuple = PyTuple_New(labels.size());
+        args[1] = PyTuple_New(labels.size());
         for (size_t i = 0; i < labels.size(); i++)
-            PyTuple_SetItem(labelstuple, i, PyUnicode_FromString(labels[i].c_str()));
-
-        // construct positional args
-        args = PyTuple_New(2);
-        PyTuple_SetItem(args, 0, ticksarray);
-        PyTuple_SetItem(args, 1, labelstuple);
-    }
-
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-    {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyString_FromString(it->second.c_str()));
+            PyTuple_SetItem(args[1], i, PyUnicode_FromString(labels[i].c_str()));
     }
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_xticks, args, kwargs);
-
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_xticks,
+                                 args, args[1] ? 2 : 1, keywords.empty() ? NULL : keywords.dict());
     if(!res) throw std::runtime_error("Call to xticks() failed");
 
     Py_DECREF(res);
 }
 
 template<typename Numeric>
-inline void xticks(const std::vector<Numeric> &ticks, const std::map<std::string, std::string>& keywords)
+inline void xticks(const std::vector<Numeric> &ticks, const Keywords& keywords)
 {
     xticks(ticks, {}, keywords);
 }
 
 template<typename Numeric>
-inline void yticks(const std::vector<Numeric> &ticks, const std::vector<std::string> &labels = {}, const std::map<std::string, std::string>& keywords = {})
+inline void yticks(const std::vector<Numeric> &ticks, const std::vector<std::string> &labels = {}, const Keywords& keywords = {})
 {
     assert(labels.size() == 0 || ticks.size() == labels.size());
 
@@ -2152,98 +5011,55 @@ inline void yticks(const std::vector<Numeric> &ticks, const std::vector<std::str
     // using numpy array
     PyObject* ticksarray = detail::get_array(ticks);
 
-    PyObject* args;
-    if(labels.size() == 0) {
-        // construct positional args
-        args = PyTuple_New(1);
-        PyTuple_SetItem(args, 0, ticksarray);
-    } else {
+    PyObject* args[2] = {ticksarray, NULL};
+    if(labels.size() != 0) {
         // make tuple of tick labels
-        PyObject* labelstuple = PyTuple_New(labels.size());
+        args[1] = PyTuple_New(labels.size());
         for (size_t i = 0; i < labels.size(); i++)
-            PyTuple_SetItem(labelstuple, i, PyUnicode_FromString(labels[i].c_str()));
-
-        // construct positional args
-        args = PyTuple_New(2);
-        PyTuple_SetItem(args, 0, ticksarray);
-        PyTuple_SetItem(args, 1, labelstuple);
-    }
-
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-    {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyString_FromString(it->second.c_str()));
+            PyTuple_SetItem(args[1], i, PyUnicode_FromString(labels[i].c_str()));
     }
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_yticks, args, kwargs);
-
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_yticks,
+                                 args, args[1] ? 2 : 1, keywords.empty() ? NULL : keywords.dict());
     if(!res) throw std::runtime_error("Call to yticks() failed");
 
     Py_DECREF(res);
 }
 
 template<typename Numeric>
-inline void yticks(const std::vector<Numeric> &ticks, const std::map<std::string, std::string>& keywords)
+inline void yticks(const std::vector<Numeric> &ticks, const Keywords& keywords)
 {
     yticks(ticks, {}, keywords);
 }
 
 template <typename Numeric> inline void margins(Numeric margin)
 {
-    // construct positional args
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, PyFloat_FromDouble(margin));
-
     PyObject* res =
-            PyObject_CallObject(detail::_interpreter::get().s_python_function_margins, args);
+            detail::call(detail::_interpreter::get().s_python_function_margins, {PyFloat_FromDouble(margin)});
     if (!res)
         throw std::runtime_error("Call to margins() failed.");
 
-    Py_DECREF(args);
     Py_DECREF(res);
 }
 
 template <typename Numeric> inline void margins(Numeric margin_x, Numeric margin_y)
 {
-    // construct positional args
-    PyObject* args = PyTuple_New(2);
-    PyTuple_SetItem(args, 0, PyFloat_FromDouble(margin_x));
-    PyTuple_SetItem(args, 1, PyFloat_FromDouble(margin_y));
-
     PyObject* res =
-            PyObject_CallObject(detail::_interpreter::get().s_python_function_margins, args);
+            detail::call(detail::_interpreter::get().s_python_function_margins,
+                         {PyFloat_FromDouble(margin_x), PyFloat_FromDouble(margin_y)});
     if (!res)
         throw std::runtime_error("Call to margins() failed.");
 
-    Py_DECREF(args);
     Py_DECREF(res);
 }
 
 
-inline void tick_params(const std::map<std::string, std::string>& keywords, const std::string axis = "both")
+inline void tick_params(const Keywords& keywords, const std::string axis = "both")
 {
   detail::_interpreter::get();
 
-  // construct positional args
-  PyObject* args;
-  args = PyTuple_New(1);
-  PyTuple_SetItem(args, 0, PyString_FromString(axis.c_str()));
-
-  // construct keyword args
-  PyObject* kwargs = PyDict_New();
-  for (std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-  {
-    PyDict_SetItemString(kwargs, it->first.c_str(), PyString_FromString(it->second.c_str()));
-  }
-
-
-  PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_tick_params, args, kwargs);
-
-  Py_DECREF(args);
-  Py_DECREF(kwargs);
+  PyObject* res = detail::call(detail::_interpreter::get().s_python_function_tick_params,
+                               {PyString_FromString(axis.c_str())}, keywords.empty() ? NULL : keywords.dict());
   if (!res) throw std::runtime_error("Call to tick_params() failed");
 
   Py_DECREF(res);
@@ -2253,16 +5069,11 @@ inline void subplot(long nrows, long ncols, long plot_number)
 {
     detail::_interpreter::get();
 
-    // construct positional args
-    PyObject* args = PyTuple_New(3);
-    PyTuple_SetItem(args, 0, PyFloat_FromDouble(nrows));
-    PyTuple_SetItem(args, 1, PyFloat_FromDouble(ncols));
-    PyTuple_SetItem(args, 2, PyFloat_FromDouble(plot_number));
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_subplot, args);
+    // matplotlib only takes integers here
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_subplot,
+                                 {PyLong_FromLong(nrows), PyLong_FromLong(ncols), PyLong_FromLong(plot_number)});
     if(!res) throw std::runtime_error("Call to subplot() failed.");
 
-    Py_DECREF(args);
     Py_DECREF(res);
 }
 
@@ -2278,60 +5089,34 @@ inline void subplot2grid(long nrows, long ncols, long rowid=0, long colid=0, lon
     PyTuple_SetItem(loc, 0, PyLong_FromLong(rowid));
     PyTuple_SetItem(loc, 1, PyLong_FromLong(colid));
 
-    PyObject* args = PyTuple_New(4);
-    PyTuple_SetItem(args, 0, shape);
-    PyTuple_SetItem(args, 1, loc);
-    PyTuple_SetItem(args, 2, PyLong_FromLong(rowspan));
-    PyTuple_SetItem(args, 3, PyLong_FromLong(colspan));
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_subplot2grid, args);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_subplot2grid,
+                                 {shape, loc, PyLong_FromLong(rowspan), PyLong_FromLong(colspan)});
     if(!res) throw std::runtime_error("Call to subplot2grid() failed.");
 
-    Py_DECREF(shape);
-    Py_DECREF(loc);
-    Py_DECREF(args);
     Py_DECREF(res);
 }
 
-inline void title(const std::string &titlestr, const std::map<std::string, std::string> &keywords = {})
+inline void title(const std::string &titlestr, const Keywords& keywords = {})
 {
     detail::_interpreter::get();
 
-    PyObject* pytitlestr = PyString_FromString(titlestr.c_str());
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, pytitlestr);
-
-    PyObject* kwargs = PyDict_New();
-    for (auto it = keywords.begin(); it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-    }
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_title, args, kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_title,
+                                 {PyString_FromString(titlestr.c_str())},
+                                 keywords.empty() ? NULL : keywords.dict());
     if(!res) throw std::runtime_error("Call to title() failed.");
 
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
     Py_DECREF(res);
 }
 
-inline void suptitle(const std::string &suptitlestr, const std::map<std::string, std::string> &keywords = {})
+inline void suptitle(const std::string &suptitlestr, const Keywords& keywords = {})
 {
     detail::_interpreter::get();
 
-    PyObject* pysuptitlestr = PyString_FromString(suptitlestr.c_str());
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, pysuptitlestr);
-
-    PyObject* kwargs = PyDict_New();
-    for (auto it = keywords.begin(); it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-    }
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_suptitle, args, kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_suptitle,
+                                 {PyString_FromString(suptitlestr.c_str())},
+                                 keywords.empty() ? NULL : keywords.dict());
     if(!res) throw std::runtime_error("Call to suptitle() failed.");
 
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
     Py_DECREF(res);
 }
 
@@ -2339,138 +5124,80 @@ inline void axis(const std::string &axisstr)
 {
     detail::_interpreter::get();
 
-    PyObject* str = PyString_FromString(axisstr.c_str());
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, str);
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_axis, args);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_axis,
+                                 {PyString_FromString(axisstr.c_str())});
     if(!res) throw std::runtime_error("Call to title() failed.");
 
-    Py_DECREF(args);
     Py_DECREF(res);
 }
 
-inline void axhline(double y, double xmin = 0., double xmax = 1., const std::map<std::string, std::string>& keywords = std::map<std::string, std::string>())
+inline void axhline(double y, double xmin = 0., double xmax = 1., const Keywords& keywords = Keywords())
 {
     detail::_interpreter::get();
 
-    // construct positional args
-    PyObject* args = PyTuple_New(3);
-    PyTuple_SetItem(args, 0, PyFloat_FromDouble(y));
-    PyTuple_SetItem(args, 1, PyFloat_FromDouble(xmin));
-    PyTuple_SetItem(args, 2, PyFloat_FromDouble(xmax));
-
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-    {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyString_FromString(it->second.c_str()));
-    }
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_axhline, args, kwargs);
-
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_axhline,
+                                 {PyFloat_FromDouble(y), PyFloat_FromDouble(xmin), PyFloat_FromDouble(xmax)},
+                                 keywords.empty() ? NULL : keywords.dict());
 
     if(res) Py_DECREF(res);
 }
 
-inline void axvline(double x, double ymin = 0., double ymax = 1., const std::map<std::string, std::string>& keywords = std::map<std::string, std::string>())
+inline void axvline(double x, double ymin = 0., double ymax = 1., const Keywords& keywords = Keywords())
 {
     detail::_interpreter::get();
 
-    // construct positional args
-    PyObject* args = PyTuple_New(3);
-    PyTuple_SetItem(args, 0, PyFloat_FromDouble(x));
-    PyTuple_SetItem(args, 1, PyFloat_FromDouble(ymin));
-    PyTuple_SetItem(args, 2, PyFloat_FromDouble(ymax));
-
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-    {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyString_FromString(it->second.c_str()));
-    }
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_axvline, args, kwargs);
-
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_axvline,
+                                 {PyFloat_FromDouble(x), PyFloat_FromDouble(ymin), PyFloat_FromDouble(ymax)},
+                                 keywords.empty() ? NULL : keywords.dict());
 
     if(res) Py_DECREF(res);
 }
 
-inline void axvspan(double xmin, double xmax, double ymin = 0., double ymax = 1., const std::map<std::string, std::string>& keywords = std::map<std::string, std::string>())
+inline void axvspan(double xmin, double xmax, double ymin = 0., double ymax = 1., const Keywords& keywords = Keywords())
 {
-    // construct positional args
-    PyObject* args = PyTuple_New(4);
-    PyTuple_SetItem(args, 0, PyFloat_FromDouble(xmin));
-    PyTuple_SetItem(args, 1, PyFloat_FromDouble(xmax));
-    PyTuple_SetItem(args, 2, PyFloat_FromDouble(ymin));
-    PyTuple_SetItem(args, 3, PyFloat_FromDouble(ymax));
+    detail::_interpreter::get();
 
     // construct keyword args
     PyObject* kwargs = PyDict_New();
-    for (auto it = keywords.begin(); it != keywords.end(); ++it) {
-      if (it->first == "linewidth" || it->first == "alpha") {
-        PyDict_SetItemString(kwargs, it->first.c_str(),
-          PyFloat_FromDouble(std::stod(it->second)));
-      } else {
-        PyDict_SetItemString(kwargs, it->first.c_str(),
-          PyString_FromString(it->second.c_str()));
-      }
+    keywords.add_to(kwargs);
+    // numbers given as strings, like "0.5", still work for these
+    for (const char* number : {"linewidth", "alpha"}) {
+      Keywords::const_iterator it = keywords.find(number);
+      if (it != keywords.end() && it->second.is_string())
+        PyDict_SetItemString(kwargs, number, PyFloat_FromDouble(it->second.to_double()));
     }
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_axvspan, args, kwargs);
-    Py_DECREF(args);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_axvspan,
+                                 {PyFloat_FromDouble(xmin), PyFloat_FromDouble(xmax),
+                                  PyFloat_FromDouble(ymin), PyFloat_FromDouble(ymax)}, kwargs);
     Py_DECREF(kwargs);
 
     if(res) Py_DECREF(res);
 }
 
-inline void xlabel(const std::string &str, const std::map<std::string, std::string> &keywords = {})
+inline void xlabel(const std::string &str, const Keywords& keywords = {})
 {
     detail::_interpreter::get();
 
-    PyObject* pystr = PyString_FromString(str.c_str());
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, pystr);
-
-    PyObject* kwargs = PyDict_New();
-    for (auto it = keywords.begin(); it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-    }
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_xlabel, args, kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_xlabel,
+                                 {PyString_FromString(str.c_str())}, keywords.empty() ? NULL : keywords.dict());
     if(!res) throw std::runtime_error("Call to xlabel() failed.");
 
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
     Py_DECREF(res);
 }
 
-inline void ylabel(const std::string &str, const std::map<std::string, std::string>& keywords = {})
+inline void ylabel(const std::string &str, const Keywords& keywords = {})
 {
     detail::_interpreter::get();
 
-    PyObject* pystr = PyString_FromString(str.c_str());
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, pystr);
-
-    PyObject* kwargs = PyDict_New();
-    for (auto it = keywords.begin(); it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-    }
-
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_ylabel, args, kwargs);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_ylabel,
+                                 {PyString_FromString(str.c_str())}, keywords.empty() ? NULL : keywords.dict());
     if(!res) throw std::runtime_error("Call to ylabel() failed.");
 
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
     Py_DECREF(res);
 }
 
-inline void set_zlabel(const std::string &str, const std::map<std::string, std::string>& keywords = {})
+inline void set_zlabel(const std::string &str, const Keywords& keywords = {})
 {
     detail::_interpreter::get();
 
@@ -2493,33 +5220,12 @@ inline void set_zlabel(const std::string &str, const std::map<std::string, std::
         if (!axis3dmod) { throw std::runtime_error("Error loading module mpl_toolkits.mplot3d!"); }
     }
 
-    PyObject* pystr = PyString_FromString(str.c_str());
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, pystr);
-
-    PyObject* kwargs = PyDict_New();
-    for (auto it = keywords.begin(); it != keywords.end(); ++it) {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-    }
-
-    PyObject *ax =
-    PyObject_CallObject(detail::_interpreter::get().s_python_function_gca,
-      detail::_interpreter::get().s_python_empty_tuple);
-    if (!ax) throw std::runtime_error("Call to gca() failed.");
-    Py_INCREF(ax);
-
-    PyObject *zlabel = PyObject_GetAttrString(ax, "set_zlabel");
-    if (!zlabel) throw std::runtime_error("Attribute set_zlabel not found.");
-    Py_INCREF(zlabel);
-
-    PyObject *res = PyObject_Call(zlabel, args, kwargs);
-    if (!res) throw std::runtime_error("Call to set_zlabel() failed.");
-    Py_DECREF(zlabel);
-
+    PyObject *ax = detail::gca();
+    PyObject *res = detail::call(detail::axes_method(ax, "set_zlabel"), {PyString_FromString(str.c_str())},
+                                 keywords.empty() ? NULL : keywords.dict());
     Py_DECREF(ax);
-    Py_DECREF(args);
-    Py_DECREF(kwargs);
-    if (res) Py_DECREF(res);
+    if (!res) throw std::runtime_error("Call to set_zlabel() failed.");
+    Py_DECREF(res);
 }
 
 inline void grid(bool flag)
@@ -2529,13 +5235,9 @@ inline void grid(bool flag)
     PyObject* pyflag = flag ? Py_True : Py_False;
     Py_INCREF(pyflag);
 
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, pyflag);
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_grid, args);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_grid, {pyflag});
     if(!res) throw std::runtime_error("Call to grid() failed.");
 
-    Py_DECREF(args);
     Py_DECREF(res);
 }
 
@@ -2546,15 +5248,13 @@ inline void show(const bool block = true)
     PyObject* res;
     if(block)
     {
-        res = PyObject_CallObject(
-                detail::_interpreter::get().s_python_function_show,
-                detail::_interpreter::get().s_python_empty_tuple);
+        res = detail::call_now(detail::_interpreter::get().s_python_function_show, {});
     }
     else
     {
         PyObject *kwargs = PyDict_New();
         PyDict_SetItemString(kwargs, "block", Py_False);
-        res = PyObject_Call( detail::_interpreter::get().s_python_function_show, detail::_interpreter::get().s_python_empty_tuple, kwargs);
+        res = detail::call_now( detail::_interpreter::get().s_python_function_show, {}, kwargs);
        Py_DECREF(kwargs);
     }
 
@@ -2567,10 +5267,9 @@ inline void show(const bool block = true)
 inline void close()
 {
     detail::_interpreter::get();
+    detail::release_axes_methods();
 
-    PyObject* res = PyObject_CallObject(
-            detail::_interpreter::get().s_python_function_close,
-            detail::_interpreter::get().s_python_empty_tuple);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_close, {});
 
     if (!res) throw std::runtime_error("Call to close() failed.");
 
@@ -2583,8 +5282,7 @@ inline void xkcd() {
     PyObject* res;
     PyObject *kwargs = PyDict_New();
 
-    res = PyObject_Call(detail::_interpreter::get().s_python_function_xkcd,
-            detail::_interpreter::get().s_python_empty_tuple, kwargs);
+    res = detail::call(detail::_interpreter::get().s_python_function_xkcd, {}, kwargs);
 
     Py_DECREF(kwargs);
 
@@ -2598,9 +5296,7 @@ inline void draw()
 {
     detail::_interpreter::get();
 
-    PyObject* res = PyObject_CallObject(
-        detail::_interpreter::get().s_python_function_draw,
-        detail::_interpreter::get().s_python_empty_tuple);
+    PyObject* res = detail::call_now(detail::_interpreter::get().s_python_function_draw, {});
 
     if (!res) throw std::runtime_error("Call to draw() failed.");
 
@@ -2612,13 +5308,10 @@ inline void pause(Numeric interval)
 {
     detail::_interpreter::get();
 
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, PyFloat_FromDouble(interval));
-
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_pause, args);
+    PyObject* res = detail::call_now(detail::_interpreter::get().s_python_function_pause,
+                                     {PyFloat_FromDouble(interval)});
     if(!res) throw std::runtime_error("Call to pause() failed.");
 
-    Py_DECREF(args);
     Py_DECREF(res);
 }
 
@@ -2626,10 +5319,6 @@ inline void save(const std::string& filename, const int dpi=0)
 {
     detail::_interpreter::get();
 
-    PyObject* pyfilename = PyString_FromString(filename.c_str());
-
-    PyObject* args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, pyfilename);
 
     PyObject* kwargs = PyDict_New();
 
@@ -2638,28 +5327,26 @@ inline void save(const std::string& filename, const int dpi=0)
         PyDict_SetItemString(kwargs, "dpi", PyLong_FromLong(dpi));
     }
 
-    PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_save, args, kwargs);
+    PyObject* res = detail::call_now(detail::_interpreter::get().s_python_function_save,
+                                     {PyString_FromString(filename.c_str())}, kwargs);
     if (!res) throw std::runtime_error("Call to save() failed.");
 
-    Py_DECREF(args);
     Py_DECREF(kwargs);
     Py_DECREF(res);
 }
 
-inline void rcparams(const std::map<std::string, std::string>& keywords = {}) {
+inline void rcparams(const Keywords& keywords = {}) {
     detail::_interpreter::get();
-    PyObject* args = PyTuple_New(0);
     PyObject* kwargs = PyDict_New();
-    for (auto it = keywords.begin(); it != keywords.end(); ++it) {
-        if ("text.usetex" == it->first)
-          PyDict_SetItemString(kwargs, it->first.c_str(), PyLong_FromLong(std::stoi(it->second.c_str())));
-        else PyDict_SetItemString(kwargs, it->first.c_str(), PyString_FromString(it->second.c_str()));
-    }
+    keywords.add_to(kwargs);
+    // "1" and "0" still work for text.usetex
+    Keywords::const_iterator usetex = keywords.find("text.usetex");
+    if (usetex != keywords.end() && usetex->second.is_string())
+        PyDict_SetItemString(kwargs, "text.usetex", PyLong_FromLong(std::stoi(usetex->second.str())));
     
     PyObject * update = PyObject_GetAttrString(detail::_interpreter::get().s_python_function_rcparams, "update");
-    PyObject * res = PyObject_Call(update, args, kwargs);
+    PyObject * res = detail::call(update, {}, kwargs);
     if(!res) throw std::runtime_error("Call to rcParams.update() failed.");
-    Py_DECREF(args);
     Py_DECREF(kwargs);
     Py_DECREF(update);
     Py_DECREF(res);
@@ -2667,10 +5354,9 @@ inline void rcparams(const std::map<std::string, std::string>& keywords = {}) {
 
 inline void clf() {
     detail::_interpreter::get();
+    detail::release_axes_methods();
 
-    PyObject *res = PyObject_CallObject(
-        detail::_interpreter::get().s_python_function_clf,
-        detail::_interpreter::get().s_python_empty_tuple);
+    PyObject *res = detail::call(detail::_interpreter::get().s_python_function_clf, {});
 
     if (!res) throw std::runtime_error("Call to clf() failed.");
 
@@ -2680,8 +5366,7 @@ inline void clf() {
 inline void cla() {
     detail::_interpreter::get();
 
-    PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_cla,
-                                        detail::_interpreter::get().s_python_empty_tuple);
+    PyObject* res = detail::call(detail::_interpreter::get().s_python_function_cla, {});
 
     if (!res)
         throw std::runtime_error("Call to cla() failed.");
@@ -2692,34 +5377,19 @@ inline void cla() {
 inline void ion() {
     detail::_interpreter::get();
 
-    PyObject *res = PyObject_CallObject(
-        detail::_interpreter::get().s_python_function_ion,
-        detail::_interpreter::get().s_python_empty_tuple);
+    PyObject *res = detail::call(detail::_interpreter::get().s_python_function_ion, {});
 
     if (!res) throw std::runtime_error("Call to ion() failed.");
 
     Py_DECREF(res);
 }
 
-inline std::vector<std::array<double, 2>> ginput(const int numClicks = 1, const std::map<std::string, std::string>& keywords = {})
+inline std::vector<std::array<double, 2>> ginput(const int numClicks = 1, const Keywords& keywords = {})
 {
     detail::_interpreter::get();
 
-    PyObject *args = PyTuple_New(1);
-    PyTuple_SetItem(args, 0, PyLong_FromLong(numClicks));
-
-    // construct keyword args
-    PyObject* kwargs = PyDict_New();
-    for(std::map<std::string, std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
-    {
-        PyDict_SetItemString(kwargs, it->first.c_str(), PyUnicode_FromString(it->second.c_str()));
-    }
-
-    PyObject* res = PyObject_Call(
-        detail::_interpreter::get().s_python_function_ginput, args, kwargs);
-
-    Py_DECREF(kwargs);
-    Py_DECREF(args);
+    PyObject* res = detail::call_now(detail::_interpreter::get().s_python_function_ginput,
+                                     {PyLong_FromLong(numClicks)}, keywords.empty() ? NULL : keywords.dict());
     if (!res) throw std::runtime_error("Call to ginput() failed.");
 
     const size_t len = PyList_Size(res);
@@ -2741,9 +5411,7 @@ inline std::vector<std::array<double, 2>> ginput(const int numClicks = 1, const
 inline void tight_layout() {
     detail::_interpreter::get();
 
-    PyObject *res = PyObject_CallObject(
-        detail::_interpreter::get().s_python_function_tight_layout,
-        detail::_interpreter::get().s_python_empty_tuple);
+    PyObject *res = detail::call(detail::_interpreter::get().s_python_function_tight_layout, {});
 
     if (!res) throw std::runtime_error("Call to tight_layout() failed.");
 
@@ -2793,6 +5461,57 @@ struct is_callable
     typedef typename is_callable_impl<std::is_class<T>::value, T>::type type;
 };
 
+// Ranges that keep their arithmetic elements in one block (std::vector,
+// std::array, C arrays, ...) can be wrapped by get_array without a copy.
+template<typename T>
+struct is_contiguous_range
+{
+    template<typename U>
+    static typename std::is_arithmetic<typename std::remove_cv<typename std::remove_pointer<
+        decltype(std::declval<const U&>().size(), std::declval<const U&>().data())>::type>::type>::type
+    test(int);
+
+    template<typename U>
+    static std::false_type test(...);
+
+    typedef decltype(test<T>(0)) type;
+};
+
+template<typename T, size_t N>
+struct is_contiguous_range<T[N]>
+{
+    typedef typename std::is_arithmetic<T>::type type;
+};
+
+template<typename Range>
+PyObject* get_range_array(const Range& r, std::true_type /*contiguous*/)
+{
+    return get_array(r.data(), r.size());
+}
+
+template<typename T, size_t N>
+PyObject* get_range_array(const T (&r)[N], std::true_type /*contiguous*/)
+{
+    return get_array(r, N);
+}
+
+template<typename Range>
+PyObject* get_range_array(const Range& r, std::false_type /*contiguous*/)
+{
+    // 2-phase lookup for distance, begin, end
+    using std::distance;
+    using std::begin;
+    using std::end;
+
+    return copy_to_array(begin(r), static_cast<size_t>(distance(begin(r), end(r))));
+}
+
+template<typename Range>
+PyObject* get_range_array(const Range& r)
+{
+    return get_range_array(r, typename is_contiguous_range<Range>::type());
+}
+
 template<typename IsYDataCallable>
 struct plot_impl { };
 
@@ -2812,28 +5531,10 @@ struct plot_impl<std::false_type>
         auto xs = distance(begin(x), end(x));
         auto ys = distance(begin(y), end(y));
         assert(xs == ys && "x and y data must have the same number of elements!");
+        (void)xs; (void)ys;
 
-        PyObject* xlist = PyList_New(xs);
-        PyObject* ylist = PyList_New(ys);
-        PyObject* pystring = PyString_FromString(format.c_str());
-
-        auto itx = begin(x), ity = begin(y);
-        for(size_t i = 0; i < xs; ++i) {
-            PyList_SetItem(xlist, i, PyFloat_FromDouble(*itx++));
-            PyList_SetItem(ylist, i, PyFloat_FromDouble(*ity++));
-        }
-
-        PyObject* plot_args = PyTuple_New(3);
-        PyTuple_SetItem(plot_args, 0, xlist);
-        PyTuple_SetItem(plot_args, 1, ylist);
-        PyTuple_SetItem(plot_args, 2, pystring);
-
-        PyObject* res = PyObject_CallObject(detail::_interpreter::get().s_python_function_plot, plot_args);
-
-        Py_DECREF(plot_args);
-        if(res) Py_DECREF(res);
-
-        return res;
+        return detail::plot(detail::_interpreter::get().s_python_function_plot,
+                            get_range_array(x), get_range_array(y), format, NULL);
     }
 };
 
@@ -2841,15 +5542,26 @@ template<>
 struct plot_impl<std::true_type>
 {
     template<typename Iterable, typename Callable>
-    bool operator()(const Iterable& ticks, const Callable& f, const std::string& format)
+    bool operator()(const Iterable& ticks, const Callable& f, const std::string& format, bool parallel = false)
     {
+        detail::_interpreter::get();
+
+        // 2-phase lookup for distance, begin, end
+        using std::distance;
+        using std::begin;
+        using std::end;
+
         if(begin(ticks) == end(ticks)) return true;
 
-        // We could use additional meta-programming to deduce the correct element type of y,
-        // but all values have to be convertible to double anyways
-        std::vector<double> y;
-        for(auto x : ticks) y.push_back(f(x));
-        return plot_impl<std::false_type>()(ticks,y,format);
+        // all values have to be convertible to double anyways, so f is
+        // evaluated straight into the buffer of the y array
+        const size_t n = static_cast<size_t>(distance(begin(ticks), end(ticks)));
+        PyObject* yarray = new_double_array(n, [&](double* y) {
+            evaluate(begin(ticks), n, f, y, parallel);
+        });
+
+        return detail::plot(detail::_interpreter::get().s_python_function_plot,
+                            get_range_array(ticks), yarray, format, NULL);
     }
 };
 
@@ -2865,6 +5577,90 @@ bool plot(const A& a, const B& b, const std::string& format, Args... args)
     return detail::plot_impl<typename detail::is_callable<B>::type>()(a,b,format) && plot(args...);
 }
 
+// Tag for plot(parallel, ticks, f, format) below.
+struct parallel_policy { };
+const parallel_policy parallel = parallel_policy();
+
+// Like plot(ticks, f, format), but evaluates f on all hardware threads. This
+// pays off for expensive functions, which have to be safe to call
+// concurrently and must not call into matplotlibcpp themselves.
+template<typename Iterable, typename Callable>
+bool plot(parallel_policy, const Iterable& ticks, const Callable& f, const std::string& format = "")
+{
+    return detail::plot_impl<std::true_type>()(ticks, f, format, true);
+}
+
+namespace detail {
+
+// Samples f on (a, b), whose ends are already known, by bisection until the
+// midpoint of every segment lies within `tolerance` pixels of the straight
+// line between its ends, or the segment is narrower than half a pixel.
+// sx and sy convert data to pixel units.
+template<typename Callable>
+void refine_samples(const Callable& f, double a, double fa, double b, double fb,
+                    double sx, double sy, double tolerance,
+                    std::vector<double>& xs, std::vector<double>& ys)
+{
+    const double m = 0.5 * (a + b);
+    const double fm = f(m);
+
+    const bool split = (b - a) * sx > 0.5 && std::abs(fm - 0.5 * (fa + fb)) * sy > tolerance;
+    if (split)
+        refine_samples(f, a, fa, m, fm, sx, sy, tolerance, xs, ys);
+    xs.push_back(m);
+    ys.push_back(fm);
+    if (split)
+        refine_samples(f, m, fm, b, fb, sx, sy, tolerance, xs, ys);
+}
+
+} // end namespace detail
+
+// Plots f on [xmin, xmax], placing the samples where the curve needs them
+// instead of on a fixed grid: segments are bisected until the drawn line is
+// off by at most `tolerance` pixels of the current axes. Flat regions thus
+// cost few evaluations of f and sharp features are still resolved.
+template<typename Callable>
+auto plot(const Callable& f, double xmin, double xmax, const std::string& format = "",
+          double tolerance = 0.5) -> decltype(static_cast<double>(f(xmin)), bool())
+{
+    detail::_interpreter::get();
+
+    double width, height;
+    detail::axes_pixel_size(width, height);
+
+    // a coarse grid of about one sample per 8 pixels gives the y range and
+    // keeps bisection from missing features between two samples
+    const size_t n = std::max<size_t>(16, static_cast<size_t>(width / 8));
+    std::vector<double> grid(n + 1), values(n + 1);
+    double ymin = INFINITY, ymax = -INFINITY;
+    for (size_t i = 0; i <= n; ++i) {
+        grid[i] = xmin + (xmax - xmin) * i / n;
+        values[i] = f(grid[i]);
+        if (std::isfinite(values[i])) {
+            ymin = std::min(ymin, values[i]);
+            ymax = std::max(ymax, values[i]);
+        }
+    }
+
+    const double sx = width / std::abs(xmax - xmin);
+    const double sy = ymax > ymin ? height / (ymax - ymin) : height;
+
+    std::vector<double> xs, ys;
+    xs.reserve(2 * n + 1);
+    ys.reserve(2 * n + 1);
+    for (size_t i = 0; i < n; ++i) {
+        xs.push_back(grid[i]);
+        ys.push_back(values[i]);
+        detail::refine_samples(f, grid[i], values[i], grid[i + 1], values[i + 1],
+                               sx, sy, tolerance, xs, ys);
+    }
+    xs.push_back(grid[n]);
+    ys.push_back(values[n]);
+
+    return detail::plot(detail::_interpreter::get().s_python_function_plot,
+                        detail::get_array(std::move(xs)), detail::get_array(std::move(ys)), format, NULL);
+}
+
 /*
  * This group of plot() functions is needed to support initializer lists, i.e. calling
  *    plot( {1,2,3,4} )
@@ -2877,7 +5673,7 @@ inline bool plot(const std::vector<double>& y, const std::string& format = "") {
     return plot<double>(y,format);
 }
 
-inline bool plot(const std::vector<double>& x, const std::vector<double>& y, const std::map<std::string, std::string>& keywords) {
+inline bool plot(const std::vector<double>& x, const std::vector<double>& y, const Keywords& keywords) {
     return plot<double>(x,y,keywords);
 }
 
@@ -2894,35 +5690,18 @@ public:
 
         assert(x.size() == y.size());
 
-        PyObject* kwargs = PyDict_New();
-        if(name != "")
-            PyDict_SetItemString(kwargs, "label", PyString_FromString(name.c_str()));
-
-        PyObject* xarray = detail::get_array(x);
-        PyObject* yarray = detail::get_array(y);
-
-        PyObject* pystring = PyString_FromString(format.c_str());
-
-        PyObject* plot_args = PyTuple_New(3);
-        PyTuple_SetItem(plot_args, 0, xarray);
-        PyTuple_SetItem(plot_args, 1, yarray);
-        PyTuple_SetItem(plot_args, 2, pystring);
-
-        PyObject* res = PyObject_Call(detail::_interpreter::get().s_python_function_plot, plot_args, kwargs);
+        init(name, detail::get_array(x), detail::get_array(y), format);
+    }
 
-        Py_DECREF(kwargs);
-        Py_DECREF(plot_args);
+    // initialization with data that is shared with matplotlib instead of
+    // borrowed, so it stays valid as long as the line exists
+    template<typename Numeric>
+    Plot(const std::string& name, const std::shared_ptr<std::vector<Numeric>>& x, const std::shared_ptr<std::vector<Numeric>>& y, const std::string& format = "") {
+        detail::_interpreter::get();
 
-        if(res)
-        {
-            line= PyList_GetItem(res, 0);
+        assert(x->size() == y->size());
 
-            if(line)
-                set_data_fct = PyObject_GetAttrString(line,"set_data");
-            else
-                Py_DECREF(line);
-            Py_DECREF(res);
-        }
+        init(name, detail::get_array(x), detail::get_array(y), format);
     }
 
     // shorter initialization with name or format only
@@ -2930,22 +5709,30 @@ public:
     Plot(const std::string& name = "", const std::string& format = "")
         : Plot(name, std::vector<double>(), std::vector<double>(), format) {}
 
+    // Borrows x and y: the caller has to keep them alive until the next
+    // update() or until the line is removed. Pass them as rvalues or
+    // shared_ptrs to avoid that.
     template<typename Numeric>
     bool update(const std::vector<Numeric>& x, const std::vector<Numeric>& y) {
         assert(x.size() == y.size());
         if(set_data_fct)
-        {
-            PyObject* xarray = detail::get_array(x);
-            PyObject* yarray = detail::get_array(y);
+            return set_data(detail::get_array(x), detail::get_array(y));
+        return false;
+    }
 
-            PyObject* plot_args = PyTuple_New(2);
-            PyTuple_SetItem(plot_args, 0, xarray);
-            PyTuple_SetItem(plot_args, 1, yarray);
+    template<typename Numeric>
+    bool update(std::vector<Numeric>&& x, std::vector<Numeric>&& y) {
+        assert(x.size() == y.size());
+        if(set_data_fct)
+            return set_data(detail::get_array(std::move(x)), detail::get_array(std::move(y)));
+        return false;
+    }
 
-            PyObject* res = PyObject_CallObject(set_data_fct, plot_args);
-            if (res) Py_DECREF(res);
-            return res;
-        }
+    template<typename Numeric>
+    bool update(const std::shared_ptr<std::vector<Numeric>>& x, const std::shared_ptr<std::vector<Numeric>>& y) {
+        assert(x->size() == y->size());
+        if(set_data_fct)
+            return set_data(detail::get_array(x), detail::get_array(y));
         return false;
     }
 
@@ -2959,8 +5746,7 @@ public:
         if(line)
         {
             auto remove_fct = PyObject_GetAttrString(line,"remove");
-            PyObject* args = PyTuple_New(0);
-            PyObject* res = PyObject_CallObject(remove_fct, args);
+            PyObject* res = detail::call(remove_fct, {});
             if (res) Py_DECREF(res);
         }
         decref();
@@ -2971,11 +5757,45 @@ public:
     }
 private:
 
+    void init(const std::string& name, PyObject* xarray, PyObject* yarray, const std::string& format) {
+        PyObject* kwargs = PyDict_New();
+        if(name != "")
+            PyDict_SetItemString(kwargs, "label", PyString_FromString(name.c_str()));
+
+        PyObject* res = detail::call_now(detail::_interpreter::get().s_python_function_plot,
+                                         {xarray, yarray, PyString_FromString(format.c_str())}, kwargs);
+
+        Py_DECREF(kwargs);
+
+        if(res)
+        {
+            line= PyList_GetItem(res, 0);
+
+            if(line)
+            {
+                // PyList_GetItem only returns a borrowed reference
+                Py_INCREF(line);
+                set_data_fct = PyObject_GetAttrString(line,"set_data");
+            }
+            Py_DECREF(res);
+        }
+    }
+
+    // steals the references to both arrays
+    bool set_data(PyObject* xarray, PyObject* yarray) {
+
+        PyObject* res = detail::call(set_data_fct, {xarray, yarray});
+        if (res) Py_DECREF(res);
+        return res;
+    }
+
     void decref() {
         if(line)
             Py_DECREF(line);
         if(set_data_fct)
             Py_DECREF(set_data_fct);
+        line = nullptr;
+        set_data_fct = nullptr;
     }
 
 